@@ -50,6 +50,8 @@ public:
 
 private:
 	EnchantSpellChecker();
+	[[nodiscard]] auto hintedValidators() const
+		-> const std::vector<not_null<enchant::Dict*>> &;
 	EnchantSpellChecker(const EnchantSpellChecker&) = delete;
 	EnchantSpellChecker& operator =(const EnchantSpellChecker&) = delete;
 
@@ -139,12 +141,12 @@ bool EnchantSpellChecker::checkSpelling(const QString &word) {
 			return checkWord(validator, w);
 		});
 	}
-	return ranges::any_of(_validators, [&](const auto &validator) {
+	const auto check = [&](not_null<enchant::Dict*> validator) {
 		// Hspell is the spell checker that only checks words in Hebrew.
 		// It returns 'true' for any non-Hebrew word,
 		// so we should skip Hspell if a word is not in Hebrew.
 		if (ranges::find_if(_hspells, [&](auto &v) {
-				return v == validator.get();
+				return v == validator;
 			}) != _hspells.end()) {
 			return false;
 		}
@@ -152,7 +154,40 @@ bool EnchantSpellChecker::checkSpelling(const QString &word) {
 			return false;
 		}
 		return checkWord(validator, w);
-	}) || _validators.empty();
+	};
+	if (::Spellchecker::LanguageHint::Empty()) {
+		return ranges::any_of(_validators, [&](const DictPtr &validator) {
+			return check(validator.get());
+		}) || _validators.empty();
+	}
+	return ranges::any_of(hintedValidators(), check)
+		|| _validators.empty();
+}
+
+// Validators are not changed after the construction,
+// so they are sorted once for each hint.
+auto EnchantSpellChecker::hintedValidators() const
+-> const std::vector<not_null<enchant::Dict*>> & {
+	struct Cached {
+		uint64 hint = 0;
+		std::vector<not_null<enchant::Dict*>> order;
+	};
+	thread_local auto cached = Cached();
+	const auto hint = ::Spellchecker::LanguageHint::Generation();
+	if (cached.hint != hint) {
+		cached.hint = hint;
+		cached.order = ranges::view::all(
+			_validators
+		) | ranges::views::transform([](const DictPtr &validator) {
+			return not_null<enchant::Dict*>(validator.get());
+		}) | ranges::to_vector;
+		ranges::stable_sort(cached.order, ranges::less(), [](
+				not_null<enchant::Dict*> validator) {
+			return ::Spellchecker::LanguageHint::Priority(
+				QString::fromStdString(validator->get_lang()));
+		});
+	}
+	return cached.order;
 }
 
 auto EnchantSpellChecker::findSuggestions(const QString &word) {
@@ -260,16 +295,26 @@ void FillSuggestionList(
 	*variants = EnchantSpellChecker::instance()->findSuggestions(wrongWord);
 }
 
+void FillCompletionList(
+		const QString &prefix,
+		std::vector<QString> *completions) {
+	// Enchant has no API to complete words.
+	completions->clear();
+}
+
 void AddWord(const QString &word) {
 	EnchantSpellChecker::instance()->addWord(word);
+	::Spellchecker::ClearVerdictCache();
 }
 
 void RemoveWord(const QString &word) {
 	EnchantSpellChecker::instance()->removeWord(word);
+	::Spellchecker::ClearVerdictCache();
 }
 
 void IgnoreWord(const QString &word) {
 	EnchantSpellChecker::instance()->ignoreWord(word);
+	::Spellchecker::ClearVerdictCache();
 }
 
 bool IsWordInDictionary(const QString &wordToCheck) {
@@ -277,11 +322,13 @@ bool IsWordInDictionary(const QString &wordToCheck) {
 }
 
 void CheckSpellingText(
-		const QString &text,
+		QStringView text,
 		MisspelledWords *misspelledWords) {
-	*misspelledWords = ::Spellchecker::RangesFromText(
+	::Spellchecker::RangesFromText(
 		text,
-		::Spellchecker::CheckSkipAndSpell);
+		::Spellchecker::CheckSkipAndSpell,
+		misspelledWords);
+	::Spellchecker::VerifyCheckResult(text, *misspelledWords);
 }
 
 bool IsSystemSpellchecker() {
@@ -74,15 +74,16 @@ bool CheckSpelling(const QString &wordToCheck) {
 
 // There's no need to check the language on the Mac.
 void CheckSpellingText(
-	const QString &text,
+	QStringView text,
 	MisspelledWords *misspelledWords) {
+	misspelledWords->clear();
 // Probably never gonna be defined.
 #ifdef SPELLCHECKER_MAC_AUTO_CHECK_TEXT
 
 	NSArray<NSTextCheckingResult *> *spellRanges =
 		[SharedSpellChecker()
-			checkString:Q2NSString(text)
-			range:NSMakeRange(0, text.length())
+			checkString:Q2NSString(QString(text.data(), text.size()))
+			range:NSMakeRange(0, text.size())
 			types:NSTextCheckingTypeSpelling
 			options:nil
 			inSpellDocumentWithTag:0
@@ -106,9 +107,10 @@ void CheckSpellingText(
 // But at the same time "testtttyy" will be marked as misspelled word.
 
 // So we have to manually split the text into words and check them separately.
-	*misspelledWords = ::Spellchecker::RangesFromText(
+	::Spellchecker::RangesFromText(
 		text,
-		::Spellchecker::CheckSkipAndSpell);
+		::Spellchecker::CheckSkipAndSpell,
+		misspelledWords);
 
 #endif
 }
@@ -144,17 +146,38 @@ void FillSuggestionList(
 	}
 }
 
+void FillCompletionList(
+	const QString &prefix,
+	std::vector<QString> *completions) {
+	completions->clear();
+	const auto wordRange = NSMakeRange(0, prefix.length());
+	NSArray<NSString *> *guesses = [SharedSpellChecker()
+		completionsForPartialWordRange:wordRange
+		inString:Q2NSString(prefix)
+		language:nil
+		inSpellDocumentWithTag:0];
+	for (NSString *guess in guesses) {
+		completions->push_back(NS2QString(guess));
+		if (completions->size() >= kMaxCompletions) {
+			return;
+		}
+	}
+}
+
 void AddWord(const QString &word) {
 	[SharedSpellChecker() learnWord:Q2NSString(word)];
+	::Spellchecker::ClearVerdictCache();
 }
 
 void RemoveWord(const QString &word) {
 	[SharedSpellChecker() unlearnWord:Q2NSString(word)];
+	::Spellchecker::ClearVerdictCache();
 }
 
 void IgnoreWord(const QString &word) {
 	[SharedSpellChecker() ignoreWord:Q2NSString(word)
 		inSpellDocumentWithTag:0];
+	::Spellchecker::ClearVerdictCache();
 }
 
 bool IsWordInDictionary(const QString &wordToCheck) {
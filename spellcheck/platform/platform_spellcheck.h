@@ -12,6 +12,7 @@
 namespace Platform::Spellchecker {
 
 constexpr auto kMaxSuggestions = 5;
+constexpr auto kMaxCompletions = 5;
 
 [[nodiscard]] bool IsSystemSpellchecker();
 [[nodiscard]] bool CheckSpelling(const QString &wordToCheck);
@@ -22,13 +23,18 @@ std::vector<QString> ActiveLanguages();
 void FillSuggestionList(
 	const QString &wrongWord,
 	std::vector<QString> *optionalSuggestions);
+// Fast enough to be called on each keystroke.
+void FillCompletionList(
+	const QString &prefix,
+	std::vector<QString> *completions);
 
 void AddWord(const QString &word);
 void RemoveWord(const QString &word);
 void IgnoreWord(const QString &word);
 
+// The misspelled words are cleared first, their capacity is reused.
 void CheckSpellingText(
-	const QString &text,
+	QStringView text,
 	MisspelledWords *misspelledWords);
 
 void UpdateLanguages(std::vector<int> languages);
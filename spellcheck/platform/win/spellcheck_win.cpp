@@ -183,7 +183,10 @@ void WindowsSpellChecker::checkSpellingText(
 	// The spellchecker marks words not from its own language as misspelled.
 	// So we only return words that are marked
 	// as misspelled in all spellcheckers.
-	MisspelledWords misspelledWords;
+	misspelledWordRanges->clear();
+	thread_local auto misspelledWords = MisspelledWords();
+	thread_local auto tempMisspelled = MisspelledWords();
+	misspelledWords.clear();
 
 	constexpr auto isActionGood = [](auto action) {
 		return action == CORRECTIVE_ACTION_GET_SUGGESTIONS
@@ -200,7 +203,7 @@ void WindowsSpellChecker::checkSpellingText(
 			continue;
 		}
 
-		MisspelledWords tempMisspelled;
+		tempMisspelled.clear();
 		ComPtr<ISpellingError> spellingError;
 		for (; hr == S_OK; hr = spellingErrors->Next(&spellingError)) {
 			ULONG startIndex = 0;
@@ -227,9 +230,11 @@ void WindowsSpellChecker::checkSpellingText(
 		if (tempMisspelled.empty()) {
 			return;
 		}
-		misspelledWords = std::move(tempMisspelled);
+		std::swap(misspelledWords, tempMisspelled);
 	}
-	*misspelledWordRanges = misspelledWords;
+	misspelledWordRanges->assign(
+		begin(misspelledWords),
+		end(misspelledWords));
 }
 
 void WindowsSpellChecker::addWord(LPCWSTR word) {
@@ -275,6 +280,8 @@ WindowsSpellChecker &SharedSpellChecker() {
 void Init() {
 	if (IsSystemSpellchecker()) {
 		crl::async(SharedSpellChecker);
+	} else {
+		ThirdParty::Init();
 	}
 }
 
@@ -312,12 +319,24 @@ void FillSuggestionList(
 		optionalSuggestions);
 }
 
+void FillCompletionList(
+	const QString &prefix,
+	std::vector<QString> *completions) {
+	if (IsSystemSpellchecker()) {
+		// ISpellChecker has no API to complete words.
+		completions->clear();
+		return;
+	}
+	ThirdParty::FillCompletionList(prefix, completions);
+}
+
 void AddWord(const QString &word) {
 	if (IsSystemSpellchecker()) {
 		SharedSpellChecker().addWord(Q2WString(word));
 	} else {
 		ThirdParty::AddWord(word);
 	}
+	::Spellchecker::ClearVerdictCache();
 }
 
 void RemoveWord(const QString &word) {
@@ -326,6 +345,7 @@ void RemoveWord(const QString &word) {
 	} else {
 		ThirdParty::RemoveWord(word);
 	}
+	::Spellchecker::ClearVerdictCache();
 }
 
 void IgnoreWord(const QString &word) {
@@ -334,6 +354,7 @@ void IgnoreWord(const QString &word) {
 	} else {
 		ThirdParty::IgnoreWord(word);
 	}
+	::Spellchecker::ClearVerdictCache();
 }
 
 bool IsWordInDictionary(const QString &wordToCheck) {
@@ -358,11 +379,17 @@ void UpdateLanguages(std::vector<int> languages) {
 }
 
 void CheckSpellingText(
-	const QString &text,
+	QStringView text,
 	MisspelledWords *misspelledWords) {
 	if (IsSystemSpellchecker()) {
+		// The system spellchecker needs a null-terminated string,
+		// and a view of a part of the text is not terminated.
+		thread_local auto buffer = std::wstring();
+		buffer.assign(
+			reinterpret_cast<const wchar_t*>(text.data()),
+			text.size());
 		SharedSpellChecker().checkSpellingText(
-			Q2WString(text),
+			buffer.c_str(),
 			misspelledWords);
 		return;
 	}
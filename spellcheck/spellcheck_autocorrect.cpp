@@ -0,0 +1,125 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "spellcheck/spellcheck_autocorrect.h"
+
+#include "spellcheck/spellcheck_value.h"
+
+#include <QtCore/QFile>
+
+namespace Spellchecker {
+namespace {
+
+class AutocorrectMap final {
+public:
+	explicit AutocorrectMap(const QString &path);
+
+	[[nodiscard]] bool valid() const;
+	[[nodiscard]] QByteArray find(const QByteArray &typo) const;
+
+private:
+	QFile _file;
+	const char *_data = nullptr;
+	qint64 _size = 0;
+
+};
+
+std::vector<std::unique_ptr<AutocorrectMap>> Maps;
+
+AutocorrectMap::AutocorrectMap(const QString &path)
+: _file(path) {
+	if (!_file.open(QIODevice::ReadOnly)) {
+		return;
+	}
+	_size = _file.size();
+	_data = reinterpret_cast<const char*>(_file.map(0, _size));
+	if (!_data) {
+		_size = 0;
+	}
+}
+
+bool AutocorrectMap::valid() const {
+	return _data != nullptr;
+}
+
+QByteArray AutocorrectMap::find(const QByteArray &typo) const {
+	const auto lineEnd = [&](qint64 from) {
+		const auto end = static_cast<const char*>(
+			memchr(_data + from, '\n', _size - from));
+		return end ? (end - _data) : _size;
+	};
+	// Both bounds are always at the start of a line.
+	auto from = qint64(0);
+	auto till = _size;
+	while (from < till) {
+		auto start = from + (till - from) / 2;
+		while (start > from && _data[start - 1] != '\n') {
+			start--;
+		}
+		const auto end = lineEnd(start);
+		const auto line = QByteArray::fromRawData(
+			_data + start,
+			end - start);
+		const auto tab = line.indexOf('\t');
+		const auto key = (tab < 0) ? line : line.left(tab);
+		if (key == typo) {
+			return (tab < 0) ? QByteArray() : line.mid(tab + 1).trimmed();
+		} else if (key < typo) {
+			from = end + 1;
+		} else {
+			till = start;
+		}
+	}
+	return QByteArray();
+}
+
+QString FindInMaps(const QString &word) {
+	const auto typo = word.toUtf8();
+	for (const auto &map : Maps) {
+		const auto correction = map->find(typo);
+		if (!correction.isEmpty()) {
+			return QString::fromUtf8(correction);
+		}
+	}
+	return QString();
+}
+
+} // namespace
+
+void UpdateAutocorrectLanguages(const std::vector<QString> &languages) {
+	Maps.clear();
+	const auto workingDir = WorkingDirPath();
+	if (workingDir.isEmpty()) {
+		return;
+	}
+	for (const auto &lang : languages) {
+		auto map = std::make_unique<AutocorrectMap>(
+			QString("%1/%2/%2.autocorrect").arg(workingDir).arg(lang));
+		if (map->valid()) {
+			Maps.push_back(std::move(map));
+		}
+	}
+}
+
+QString FindAutocorrection(const QString &word) {
+	if (Maps.empty() || word.isEmpty()) {
+		return QString();
+	}
+	if (const auto result = FindInMaps(word); !result.isEmpty()) {
+		return result;
+	}
+	// "Teh" at the start of a sentence should become "The".
+	const auto lower = word.toLower();
+	if (lower == word || word.mid(1) != lower.mid(1)) {
+		return QString();
+	}
+	const auto result = FindInMaps(lower);
+	return result.isEmpty()
+		? result
+		: (result.at(0).toUpper() + result.mid(1));
+}
+
+} // namespace Spellchecker
@@ -0,0 +1,24 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+#include "spellcheck/spellcheck_types.h"
+
+namespace Spellchecker {
+
+// Typos are read from "<working dir>/<lang>/<lang>.autocorrect" files.
+// Each line is "typo\tcorrection" in UTF-8 and lines are sorted by bytes,
+// so the mapped file is searched in place without parsing.
+
+// Thread: Main.
+void UpdateAutocorrectLanguages(const std::vector<QString> &languages);
+
+// Thread: Main.
+// Returns an empty string if there is no known correction.
+[[nodiscard]] QString FindAutocorrection(const QString &word);
+
+} // namespace Spellchecker
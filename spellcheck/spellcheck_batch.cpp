@@ -0,0 +1,162 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "spellcheck/spellcheck_batch.h"
+
+#include "spellcheck/platform/platform_spellcheck.h"
+
+#include <QtCore/QThread>
+
+#include <mutex>
+#include <thread>
+
+namespace Spellchecker {
+namespace {
+
+// Each worker takes documents from its own slice and steals
+// a half of the largest slice of others when its own is over.
+class WorkStealingQueue final {
+public:
+	WorkStealingQueue(int count, int workers);
+
+	[[nodiscard]] int next(int worker);
+
+private:
+	struct Slice {
+		std::mutex mutex;
+		int from = 0;
+		int till = 0;
+	};
+
+	[[nodiscard]] bool steal(int worker);
+
+	std::vector<Slice> _slices;
+
+};
+
+WorkStealingQueue::WorkStealingQueue(int count, int workers)
+: _slices(workers) {
+	for (auto i = 0; i < workers; i++) {
+		_slices[i].from = int(int64(count) * i / workers);
+		_slices[i].till = int(int64(count) * (i + 1) / workers);
+	}
+}
+
+int WorkStealingQueue::next(int worker) {
+	auto &slice = _slices[worker];
+	do {
+		std::lock_guard lock(slice.mutex);
+		if (slice.from < slice.till) {
+			return slice.from++;
+		}
+	} while (steal(worker));
+	return -1;
+}
+
+bool WorkStealingQueue::steal(int worker) {
+	auto victim = -1;
+	auto largest = 0;
+	for (auto i = 0; i < _slices.size(); i++) {
+		if (i == worker) {
+			continue;
+		}
+		std::lock_guard lock(_slices[i].mutex);
+		if (const auto size = _slices[i].till - _slices[i].from;
+			size > largest) {
+			victim = i;
+			largest = size;
+		}
+	}
+	if (victim < 0) {
+		return false;
+	}
+	auto from = 0;
+	auto till = 0;
+	{
+		auto &slice = _slices[victim];
+		std::lock_guard lock(slice.mutex);
+		if (slice.from >= slice.till) {
+			// Someone was faster, try again.
+			return true;
+		}
+		till = slice.till;
+		from = slice.from + (slice.till - slice.from) / 2;
+		slice.till = from;
+	}
+	std::lock_guard lock(_slices[worker].mutex);
+	_slices[worker].from = from;
+	_slices[worker].till = till;
+	return true;
+}
+
+} // namespace
+
+double BatchCheckResult::wordsPerSecond() const {
+	return duration
+		? (wordsCount * 1000. / duration)
+		: 0.;
+}
+
+int CountWords(QStringView text) {
+	auto result = 0;
+	auto inWord = false;
+	for (auto i = 0; i < text.size(); i++) {
+		const auto letter = text.at(i).isLetterOrNumber();
+		if (letter && !inWord) {
+			result++;
+		}
+		inWord = letter;
+	}
+	return result;
+}
+
+BatchCheckResult CheckSpellingTexts(
+		const std::vector<QString> &texts,
+		int threads) {
+	const auto started = crl::now();
+	const auto workers = std::clamp(
+		(threads > 0) ? threads : QThread::idealThreadCount(),
+		1,
+		std::max(int(texts.size()), 1));
+
+	auto result = BatchCheckResult();
+	result.misspelledWords.resize(texts.size());
+
+	auto queue = WorkStealingQueue(texts.size(), workers);
+	auto wordsCount = std::atomic<int64>(0);
+	// Workers check with the language hint of the calling thread.
+	const auto languages = LanguageHint::Current();
+	const auto work = [&](int worker) {
+		const auto hint = LanguageHint(languages);
+		auto words = int64(0);
+		for (auto i = queue.next(worker); i >= 0; i = queue.next(worker)) {
+			Platform::Spellchecker::CheckSpellingText(
+				texts[i],
+				&result.misspelledWords[i]);
+			words += CountWords(texts[i]);
+		}
+		wordsCount += words;
+	};
+
+	// Workers have their own threads instead of the crl pool,
+	// so the call can be made from a task of the pool as well.
+	auto threadsList = std::vector<std::thread>();
+	threadsList.reserve(workers - 1);
+	for (auto i = 1; i < workers; i++) {
+		threadsList.emplace_back(work, i);
+	}
+	// The calling thread is a worker too.
+	work(0);
+	for (auto &thread : threadsList) {
+		thread.join();
+	}
+
+	result.wordsCount = wordsCount.load();
+	result.duration = crl::now() - started;
+	return result;
+}
+
+} // namespace Spellchecker
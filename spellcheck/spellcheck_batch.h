@@ -0,0 +1,32 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+#include "spellcheck/spellcheck_types.h"
+
+namespace Spellchecker {
+
+struct BatchCheckResult {
+	// In the same order as the checked texts.
+	std::vector<MisspelledWords> misspelledWords;
+	int64 wordsCount = 0;
+	crl::time duration = 0;
+
+	[[nodiscard]] double wordsPerSecond() const;
+};
+
+// Checks many documents at once for offline processing,
+// the verdict cache is shared by all of them.
+// Thread: Any. The call is blocking.
+[[nodiscard]] BatchCheckResult CheckSpellingTexts(
+	const std::vector<QString> &texts,
+	int threads = 0);
+
+// Runs of letters and numbers, good enough for throughput numbers.
+[[nodiscard]] int CountWords(QStringView text);
+
+} // namespace Spellchecker
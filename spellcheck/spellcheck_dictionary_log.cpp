@@ -0,0 +1,281 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "spellcheck/spellcheck_dictionary_log.h"
+
+#include <cstring>
+#include <random>
+
+namespace Spellchecker {
+namespace {
+
+constexpr auto kSignature = "SPDL";
+constexpr auto kSignatureSize = 4;
+constexpr auto kVersion = char(1);
+constexpr auto kMaxWordBytes = 1024;
+constexpr auto kRemovedFlag = char(1);
+
+void WriteVarint(QByteArray &data, uint64 value) {
+	while (value >= 0x80) {
+		data.append(char((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	data.append(char(value));
+}
+
+class Reader final {
+public:
+	explicit Reader(const QByteArray &data) : _data(data) {
+	}
+
+	[[nodiscard]] bool atEnd() const {
+		return _offset == _data.size();
+	}
+	[[nodiscard]] bool failed() const {
+		return _failed;
+	}
+
+	[[nodiscard]] uint64 varint() {
+		auto result = uint64(0);
+		for (auto shift = 0; shift < 64; shift += 7) {
+			if (_offset == _data.size()) {
+				break;
+			}
+			const auto byte = uchar(_data[_offset++]);
+			result |= uint64(byte & 0x7F) << shift;
+			if (!(byte & 0x80)) {
+				return result;
+			}
+		}
+		_failed = true;
+		return 0;
+	}
+
+	void skip(int count) {
+		_offset = std::min(_offset + count, int(_data.size()));
+	}
+
+	[[nodiscard]] char byte() {
+		if (_offset == _data.size()) {
+			_failed = true;
+			return 0;
+		}
+		return _data[_offset++];
+	}
+
+	[[nodiscard]] QByteArray bytes(uint64 size) {
+		if (size > uint64(_data.size() - _offset)) {
+			_failed = true;
+			return QByteArray();
+		}
+		const auto result = _data.mid(_offset, int(size));
+		_offset += int(size);
+		return result;
+	}
+
+private:
+	const QByteArray &_data;
+	int _offset = 0;
+	bool _failed = false;
+
+};
+
+[[nodiscard]] uint64 RandomDevice() {
+	auto generator = std::mt19937_64(std::random_device()());
+	auto result = uint64(0);
+	while (!result) {
+		result = generator();
+	}
+	return result;
+}
+
+} // namespace
+
+DictionaryLog::DictionaryLog() : DictionaryLog(RandomDevice()) {
+}
+
+DictionaryLog::DictionaryLog(uint64 device) : _device(device) {
+}
+
+std::optional<DictionaryLog> DictionaryLog::FromSerialized(
+		const QByteArray &data) {
+	auto records = std::vector<Record>();
+	const auto device = Decode(data, &records);
+	if (!device) {
+		return std::nullopt;
+	}
+	auto result = DictionaryLog(*device);
+	for (auto &record : records) {
+		const auto &entry = record.entry;
+		result._clock = std::max(result._clock, entry.stamp);
+		result._lastSequence = std::max(
+			result._lastSequence,
+			entry.sequence);
+
+		// Later records of the same word were appended after the earlier.
+		auto &existing = result._entries[std::move(record.word)];
+		if (existing.sequence) {
+			result._redundantRecords++;
+		}
+		if (existing.sequence < entry.sequence) {
+			existing = entry;
+		}
+	}
+	return result;
+}
+
+uint64 DictionaryLog::device() const {
+	return _device;
+}
+
+uint64 DictionaryLog::lastSequence() const {
+	return _lastSequence;
+}
+
+std::vector<QString> DictionaryLog::words() const {
+	auto result = std::vector<QString>();
+	for (const auto &[word, entry] : _entries) {
+		if (!entry.removed) {
+			result.push_back(word);
+		}
+	}
+	return result;
+}
+
+int DictionaryLog::redundantRecords() const {
+	return _redundantRecords;
+}
+
+void DictionaryLog::add(const QString &word) {
+	change(word, false);
+}
+
+void DictionaryLog::remove(const QString &word) {
+	change(word, true);
+}
+
+void DictionaryLog::change(const QString &word, bool removed) {
+	auto &entry = _entries[word];
+	if (entry.sequence) {
+		_redundantRecords++;
+	}
+	entry.sequence = ++_lastSequence;
+	entry.stamp = ++_clock;
+	entry.device = _device;
+	entry.removed = removed;
+}
+
+QByteArray DictionaryLog::header() const {
+	auto result = QByteArray(kSignature, kSignatureSize);
+	result.append(kVersion);
+	WriteVarint(result, _device);
+	return result;
+}
+
+QByteArray DictionaryLog::records(uint64 sinceSequence) const {
+	auto changed = std::vector<std::pair<const QString*, const Entry*>>();
+	for (const auto &[word, entry] : _entries) {
+		if (entry.sequence > sinceSequence) {
+			changed.emplace_back(&word, &entry);
+		}
+	}
+	ranges::sort(changed, ranges::less(), [](const auto &pair) {
+		return pair.second->sequence;
+	});
+
+	auto result = QByteArray();
+	for (const auto &[word, entry] : changed) {
+		const auto utf8 = word->toUtf8();
+		WriteVarint(result, entry->sequence);
+		WriteVarint(result, entry->stamp);
+		WriteVarint(result, entry->device);
+		result.append(entry->removed ? kRemovedFlag : char(0));
+		WriteVarint(result, utf8.size());
+		result.append(utf8);
+	}
+	return result;
+}
+
+QByteArray DictionaryLog::delta(uint64 sinceSequence) const {
+	return header() + records(sinceSequence);
+}
+
+std::optional<uint64> DictionaryLog::Decode(
+		const QByteArray &data,
+		std::vector<Record> *records) {
+	if (data.size() <= kSignatureSize
+		|| memcmp(data.constData(), kSignature, kSignatureSize)
+		|| data[kSignatureSize] != kVersion) {
+		return std::nullopt;
+	}
+	auto reader = Reader(data);
+	reader.skip(kSignatureSize + 1);
+	const auto device = reader.varint();
+	while (!reader.atEnd() && !reader.failed()) {
+		auto entry = Entry();
+		entry.sequence = reader.varint();
+		entry.stamp = reader.varint();
+		entry.device = reader.varint();
+		entry.removed = (reader.byte() == kRemovedFlag);
+		const auto size = reader.varint();
+		if (size > kMaxWordBytes) {
+			return std::nullopt;
+		}
+		auto word = QString::fromUtf8(reader.bytes(size));
+		if (reader.failed() || word.isEmpty() || !entry.sequence) {
+			return std::nullopt;
+		}
+		records->push_back({ std::move(word), entry });
+	}
+	if (reader.failed() || !device) {
+		return std::nullopt;
+	}
+	return device;
+}
+
+auto DictionaryLog::merge(
+		const QByteArray &delta,
+		uint64 *peerSequence,
+		Fn<bool(const QString &word)> acceptAdded)
+-> std::optional<Changes> {
+	auto records = std::vector<Record>();
+	if (!Decode(delta, &records)) {
+		return std::nullopt;
+	}
+	auto result = Changes();
+	for (auto &record : records) {
+		const auto &theirs = record.entry;
+		*peerSequence = std::max(*peerSequence, theirs.sequence);
+		_clock = std::max(_clock, theirs.stamp);
+
+		const auto it = _entries.find(record.word);
+		const auto wasAdded = (it != end(_entries)) && !it->second.removed;
+		if (it != end(_entries)) {
+			const auto &ours = it->second;
+			if (std::tie(ours.stamp, ours.device)
+				>= std::tie(theirs.stamp, theirs.device)) {
+				continue;
+			}
+		}
+		const auto adding = !theirs.removed && !wasAdded;
+		if (adding && acceptAdded && !acceptAdded(record.word)) {
+			continue;
+		} else if (it != end(_entries)) {
+			_redundantRecords++;
+		}
+		auto &entry = _entries[record.word];
+		entry = theirs;
+		entry.sequence = ++_lastSequence;
+		if (entry.removed && wasAdded) {
+			result.removed.push_back(std::move(record.word));
+		} else if (!entry.removed && !wasAdded) {
+			result.added.push_back(std::move(record.word));
+		}
+	}
+	return result;
+}
+
+} // namespace Spellchecker
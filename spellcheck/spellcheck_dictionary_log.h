@@ -0,0 +1,93 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+#include <QtCore/QByteArray>
+
+#include <map>
+#include <optional>
+
+namespace Spellchecker {
+
+// The custom dictionary as a log of added and removed words,
+// so devices exchange only the changes since their last sync.
+//
+// Each word keeps only its last operation. Operations from different
+// devices are ordered by a Lamport clock, ties are broken by device id.
+// Local sequence numbers count every change of this log, including
+// the merged ones, and a peer asks for the changes after the last
+// sequence it has seen.
+//
+// The encoding is a header with the device id followed by records
+// of varints, so new records are appended to a saved log as they are.
+class DictionaryLog final {
+public:
+	struct Changes {
+		std::vector<QString> added;
+		std::vector<QString> removed;
+	};
+
+	// A new log with a random device id.
+	DictionaryLog();
+
+	// Restores a saved log with its device id and sequence numbers.
+	[[nodiscard]] static std::optional<DictionaryLog> FromSerialized(
+		const QByteArray &data);
+
+	[[nodiscard]] uint64 device() const;
+	[[nodiscard]] uint64 lastSequence() const;
+	[[nodiscard]] std::vector<QString> words() const;
+
+	// Appended records to restore the log: more than one per word.
+	[[nodiscard]] int redundantRecords() const;
+
+	void add(const QString &word);
+	void remove(const QString &word);
+
+	[[nodiscard]] QByteArray header() const;
+	[[nodiscard]] QByteArray records(uint64 sinceSequence) const;
+
+	// The header with records after the sequence.
+	[[nodiscard]] QByteArray delta(uint64 sinceSequence) const;
+
+	// Nothing is applied from malformed data.
+	// Words that would be added are skipped if not accepted,
+	// so the log keeps only the applied operations.
+	// The last sequence of the peer is written to the pointer.
+	[[nodiscard]] std::optional<Changes> merge(
+		const QByteArray &delta,
+		uint64 *peerSequence,
+		Fn<bool(const QString &word)> acceptAdded = nullptr);
+
+private:
+	struct Entry {
+		uint64 sequence = 0;
+		uint64 stamp = 0;
+		uint64 device = 0;
+		bool removed = false;
+	};
+	struct Record {
+		QString word;
+		Entry entry;
+	};
+
+	explicit DictionaryLog(uint64 device);
+
+	void change(const QString &word, bool removed);
+	[[nodiscard]] static std::optional<uint64> Decode(
+		const QByteArray &data,
+		std::vector<Record> *records);
+
+	uint64 _device = 0;
+	uint64 _clock = 0;
+	uint64 _lastSequence = 0;
+	int _redundantRecords = 0;
+	std::map<QString, Entry> _entries;
+
+};
+
+} // namespace Spellchecker
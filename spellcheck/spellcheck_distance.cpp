@@ -0,0 +1,197 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "spellcheck/spellcheck_distance.h"
+
+namespace Spellchecker {
+namespace {
+
+constexpr auto kMaxBitParallelLength = 64;
+
+int PlainLevenshtein(QStringView a, QStringView b) {
+	auto previous = std::vector<int>(b.size() + 1);
+	auto current = std::vector<int>(b.size() + 1);
+	for (auto j = 0; j <= b.size(); j++) {
+		previous[j] = j;
+	}
+	for (auto i = 1; i <= a.size(); i++) {
+		current[0] = i;
+		for (auto j = 1; j <= b.size(); j++) {
+			const auto cost = (a.at(i - 1) == b.at(j - 1)) ? 0 : 1;
+			current[j] = std::min({
+				previous[j] + 1,
+				current[j - 1] + 1,
+				previous[j - 1] + cost,
+			});
+		}
+		std::swap(previous, current);
+	}
+	return previous[b.size()];
+}
+
+int PlainDamerau(QStringView a, QStringView b) {
+	auto beforePrevious = std::vector<int>(b.size() + 1);
+	auto previous = std::vector<int>(b.size() + 1);
+	auto current = std::vector<int>(b.size() + 1);
+	for (auto j = 0; j <= b.size(); j++) {
+		previous[j] = j;
+	}
+	for (auto i = 1; i <= a.size(); i++) {
+		current[0] = i;
+		for (auto j = 1; j <= b.size(); j++) {
+			const auto cost = (a.at(i - 1) == b.at(j - 1)) ? 0 : 1;
+			current[j] = std::min({
+				previous[j] + 1,
+				current[j - 1] + 1,
+				previous[j - 1] + cost,
+			});
+			if (i > 1
+				&& j > 1
+				&& a.at(i - 1) == b.at(j - 2)
+				&& a.at(i - 2) == b.at(j - 1)) {
+				current[j] = std::min(
+					current[j],
+					beforePrevious[j - 2] + 1);
+			}
+		}
+		std::swap(beforePrevious, previous);
+		std::swap(previous, current);
+	}
+	return previous[b.size()];
+}
+
+} // namespace
+
+DistanceMatcher::DistanceMatcher(QStringView pattern)
+: _pattern(pattern.data(), pattern.size())
+, _bitParallel(pattern.size() <= kMaxBitParallelLength) {
+	if (!_bitParallel) {
+		return;
+	}
+	for (auto i = 0; i < pattern.size(); i++) {
+		const auto bit = (uint64(1) << i);
+		const auto code = pattern.at(i).unicode();
+		if (code < _asciiMasks.size()) {
+			_asciiMasks[code] |= bit;
+			continue;
+		}
+		const auto it = ranges::find(
+			_otherMasks,
+			code,
+			&std::pair<ushort, uint64>::first);
+		if (it != end(_otherMasks)) {
+			it->second |= bit;
+		} else {
+			_otherMasks.emplace_back(code, bit);
+		}
+	}
+}
+
+uint64 DistanceMatcher::mask(QChar c) const {
+	const auto code = c.unicode();
+	if (code < _asciiMasks.size()) {
+		return _asciiMasks[code];
+	}
+	// Words are short, so the linear search is faster than any map.
+	for (const auto &[character, bits] : _otherMasks) {
+		if (character == code) {
+			return bits;
+		}
+	}
+	return 0;
+}
+
+int DistanceMatcher::levenshtein(QStringView text) const {
+	if (!_bitParallel) {
+		return PlainLevenshtein(_pattern, text);
+	}
+	const auto length = _pattern.size();
+	if (!length) {
+		return text.size();
+	}
+	const auto last = uint64(1) << (length - 1);
+	auto vp = ~uint64(0);
+	auto vn = uint64(0);
+	auto distance = length;
+	for (auto j = 0; j < text.size(); j++) {
+		const auto eq = mask(text.at(j));
+		const auto d0 = (((eq & vp) + vp) ^ vp) | eq | vn;
+		auto hp = vn | ~(d0 | vp);
+		auto hn = d0 & vp;
+		if (hp & last) {
+			distance++;
+		} else if (hn & last) {
+			distance--;
+		}
+		hp = (hp << 1) | 1;
+		hn = (hn << 1);
+		vp = hn | ~(d0 | hp);
+		vn = hp & d0;
+	}
+	return distance;
+}
+
+int DistanceMatcher::damerau(QStringView text) const {
+	if (!_bitParallel) {
+		return PlainDamerau(_pattern, text);
+	}
+	const auto length = _pattern.size();
+	if (!length) {
+		return text.size();
+	}
+	const auto last = uint64(1) << (length - 1);
+	auto vp = ~uint64(0);
+	auto vn = uint64(0);
+	auto d0 = uint64(0);
+	auto previousEq = uint64(0);
+	auto distance = length;
+	for (auto j = 0; j < text.size(); j++) {
+		const auto eq = mask(text.at(j));
+		const auto transposition = (((~d0) & eq) << 1) & previousEq;
+		d0 = (((eq & vp) + vp) ^ vp) | eq | vn | transposition;
+		auto hp = vn | ~(d0 | vp);
+		auto hn = d0 & vp;
+		if (hp & last) {
+			distance++;
+		} else if (hn & last) {
+			distance--;
+		}
+		hp = (hp << 1) | 1;
+		hn = (hn << 1);
+		vp = hn | ~(d0 | hp);
+		vn = hp & d0;
+		previousEq = eq;
+	}
+	return distance;
+}
+
+std::vector<int> DistanceMatcher::damerau(
+		const std::vector<QString> &candidates,
+		int maxDistance) const {
+	auto result = std::vector<int>();
+	result.reserve(candidates.size());
+	for (const auto &candidate : candidates) {
+		const auto lengthDiff = std::abs(candidate.size() - _pattern.size());
+		result.push_back((lengthDiff > maxDistance)
+			? (maxDistance + 1)
+			: std::min(damerau(candidate), maxDistance + 1));
+	}
+	return result;
+}
+
+int LevenshteinDistance(QStringView a, QStringView b) {
+	return (a.size() < b.size())
+		? DistanceMatcher(a).levenshtein(b)
+		: DistanceMatcher(b).levenshtein(a);
+}
+
+int DamerauDistance(QStringView a, QStringView b) {
+	return (a.size() < b.size())
+		? DistanceMatcher(a).damerau(b)
+		: DistanceMatcher(b).damerau(a);
+}
+
+} // namespace Spellchecker
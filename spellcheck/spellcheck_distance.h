@@ -0,0 +1,47 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+#include "spellcheck/spellcheck_types.h"
+
+#include <array>
+
+namespace Spellchecker {
+
+// Edit distances over UTF-16 code units.
+// Damerau distance is the optimal string alignment one,
+// so a transposed pair can't be edited again.
+[[nodiscard]] int LevenshteinDistance(QStringView a, QStringView b);
+[[nodiscard]] int DamerauDistance(QStringView a, QStringView b);
+
+// Compares one word against many candidates.
+// Patterns up to 64 code units use the bit-parallel algorithm of Myers
+// in the formulation of Hyyrö, longer ones fall back to the plain DP.
+class DistanceMatcher final {
+public:
+	explicit DistanceMatcher(QStringView pattern);
+
+	[[nodiscard]] int levenshtein(QStringView text) const;
+	[[nodiscard]] int damerau(QStringView text) const;
+
+	// Returns maxDistance + 1 for candidates that are too far
+	// by the length difference alone.
+	[[nodiscard]] std::vector<int> damerau(
+		const std::vector<QString> &candidates,
+		int maxDistance) const;
+
+private:
+	[[nodiscard]] uint64 mask(QChar c) const;
+
+	QString _pattern;
+	std::array<uint64, 128> _asciiMasks = { { 0 } };
+	std::vector<std::pair<ushort, uint64>> _otherMasks;
+	bool _bitParallel = false;
+
+};
+
+} // namespace Spellchecker
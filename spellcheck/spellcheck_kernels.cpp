@@ -0,0 +1,282 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "spellcheck/spellcheck_kernels.h"
+
+#include <array>
+#include <atomic>
+
+#if defined(__x86_64__) || defined(__i386__) \
+	|| defined(_M_X64) || defined(_M_IX86)
+#define SPELLCHECK_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define SPELLCHECK_TARGET(features)
+#else // _MSC_VER && !__clang__
+#define SPELLCHECK_TARGET(features) __attribute__((target(features)))
+#endif // _MSC_VER && !__clang__
+#elif defined(__aarch64__) || defined(_M_ARM64) // x86
+#define SPELLCHECK_KERNELS_NEON
+#include <arm_neon.h>
+#endif // x86 || arm64
+
+namespace Spellchecker {
+namespace {
+
+// In the order of TextKernels.
+const auto kKernelsNames = std::array<const char*, 4>{
+	"scalar",
+	"sse42",
+	"avx2",
+	"neon",
+};
+
+struct Kernels {
+	int (*asciiPrefixLength)(const QChar *text, int size) = nullptr;
+	void (*narrowAscii)(const QChar *text, int size, char *out) = nullptr;
+};
+
+[[nodiscard]] const ushort *Utf16(const QChar *text) {
+	return reinterpret_cast<const ushort*>(text);
+}
+
+int AsciiPrefixLengthScalar(const QChar *text, int size) {
+	auto i = 0;
+	while (i != size && text[i].unicode() < 0x80) {
+		i++;
+	}
+	return i;
+}
+
+void NarrowAsciiScalar(const QChar *text, int size, char *out) {
+	for (auto i = 0; i != size; i++) {
+		out[i] = char(text[i].unicode());
+	}
+}
+
+#ifdef SPELLCHECK_KERNELS_X86
+
+// The vector loops stop at the first block with a non-ASCII character,
+// the scalar loop finds it in the block.
+SPELLCHECK_TARGET("sse4.2")
+int AsciiPrefixLengthSse42(const QChar *text, int size) {
+	const auto data = Utf16(text);
+	const auto mask = _mm_set1_epi16(short(0xFF80));
+	auto i = 0;
+	for (; i + 8 <= size; i += 8) {
+		const auto chunk = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(data + i));
+		if (!_mm_testz_si128(chunk, mask)) {
+			break;
+		}
+	}
+	return i + AsciiPrefixLengthScalar(text + i, size - i);
+}
+
+SPELLCHECK_TARGET("sse4.2")
+void NarrowAsciiSse42(const QChar *text, int size, char *out) {
+	const auto data = Utf16(text);
+	auto i = 0;
+	for (; i + 16 <= size; i += 16) {
+		const auto low = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(data + i));
+		const auto high = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(data + i + 8));
+		_mm_storeu_si128(
+			reinterpret_cast<__m128i*>(out + i),
+			_mm_packus_epi16(low, high));
+	}
+	NarrowAsciiScalar(text + i, size - i, out + i);
+}
+
+SPELLCHECK_TARGET("avx2")
+int AsciiPrefixLengthAvx2(const QChar *text, int size) {
+	const auto data = Utf16(text);
+	const auto mask = _mm256_set1_epi16(short(0xFF80));
+	auto i = 0;
+	for (; i + 16 <= size; i += 16) {
+		const auto chunk = _mm256_loadu_si256(
+			reinterpret_cast<const __m256i*>(data + i));
+		if (!_mm256_testz_si256(chunk, mask)) {
+			break;
+		}
+	}
+	return i + AsciiPrefixLengthScalar(text + i, size - i);
+}
+
+SPELLCHECK_TARGET("avx2")
+void NarrowAsciiAvx2(const QChar *text, int size, char *out) {
+	const auto data = Utf16(text);
+	auto i = 0;
+	for (; i + 32 <= size; i += 32) {
+		const auto low = _mm256_loadu_si256(
+			reinterpret_cast<const __m256i*>(data + i));
+		const auto high = _mm256_loadu_si256(
+			reinterpret_cast<const __m256i*>(data + i + 16));
+		// Packing works in 128-bit lanes, so the quarters are reordered.
+		const auto packed = _mm256_permute4x64_epi64(
+			_mm256_packus_epi16(low, high),
+			0xD8);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+	}
+	NarrowAsciiScalar(text + i, size - i, out + i);
+}
+
+struct CpuFeatures {
+	bool sse42 = false;
+	bool avx2 = false;
+};
+
+CpuFeatures DetectCpuFeatures() {
+	auto result = CpuFeatures();
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4] = { 0 };
+	__cpuid(info, 0);
+	const auto maxLeaf = info[0];
+	__cpuid(info, 1);
+	result.sse42 = (info[2] & (1 << 20)) != 0;
+	// AVX registers should also be saved by the system.
+	const auto osxsave = (info[2] & (1 << 27)) != 0;
+	if (maxLeaf >= 7 && osxsave && (_xgetbv(0) & 6) == 6) {
+		__cpuidex(info, 7, 0);
+		result.avx2 = (info[1] & (1 << 5)) != 0;
+	}
+#else // _MSC_VER && !__clang__
+	__builtin_cpu_init();
+	result.sse42 = __builtin_cpu_supports("sse4.2");
+	result.avx2 = __builtin_cpu_supports("avx2");
+#endif // _MSC_VER && !__clang__
+	return result;
+}
+
+#elif defined SPELLCHECK_KERNELS_NEON // SPELLCHECK_KERNELS_X86
+
+int AsciiPrefixLengthNeon(const QChar *text, int size) {
+	const auto data = Utf16(text);
+	auto i = 0;
+	for (; i + 8 <= size; i += 8) {
+		if (vmaxvq_u16(vld1q_u16(data + i)) >= 0x80) {
+			break;
+		}
+	}
+	return i + AsciiPrefixLengthScalar(text + i, size - i);
+}
+
+void NarrowAsciiNeon(const QChar *text, int size, char *out) {
+	const auto data = Utf16(text);
+	auto i = 0;
+	for (; i + 8 <= size; i += 8) {
+		vst1_u8(
+			reinterpret_cast<uint8_t*>(out + i),
+			vmovn_u16(vld1q_u16(data + i)));
+	}
+	NarrowAsciiScalar(text + i, size - i, out + i);
+}
+
+#endif // SPELLCHECK_KERNELS_X86 || SPELLCHECK_KERNELS_NEON
+
+// In the order of TextKernels, unsupported ones are empty.
+const auto kKernels = std::array<Kernels, 4>{
+	Kernels{ AsciiPrefixLengthScalar, NarrowAsciiScalar },
+#ifdef SPELLCHECK_KERNELS_X86
+	Kernels{ AsciiPrefixLengthSse42, NarrowAsciiSse42 },
+	Kernels{ AsciiPrefixLengthAvx2, NarrowAsciiAvx2 },
+#else // SPELLCHECK_KERNELS_X86
+	Kernels(),
+	Kernels(),
+#endif // SPELLCHECK_KERNELS_X86
+#ifdef SPELLCHECK_KERNELS_NEON
+	Kernels{ AsciiPrefixLengthNeon, NarrowAsciiNeon },
+#else // SPELLCHECK_KERNELS_NEON
+	Kernels(),
+#endif // SPELLCHECK_KERNELS_NEON
+};
+
+bool Supported(TextKernels kernels) {
+	if (!kKernels[int(kernels)].asciiPrefixLength) {
+		return false;
+	}
+#ifdef SPELLCHECK_KERNELS_X86
+	static const auto features = DetectCpuFeatures();
+	if (kernels == TextKernels::Sse42) {
+		return features.sse42;
+	} else if (kernels == TextKernels::Avx2) {
+		return features.avx2;
+	}
+#endif // SPELLCHECK_KERNELS_X86
+	return true;
+}
+
+TextKernels ChooseKernels() {
+	const auto forced = TextKernelsFromName(
+		QString::fromLatin1(qgetenv("DESKTOP_APP_SPELLCHECK_KERNELS")));
+	if (forced && Supported(*forced)) {
+		return *forced;
+	}
+	for (const auto kernels : {
+		TextKernels::Avx2,
+		TextKernels::Neon,
+		TextKernels::Sse42,
+	}) {
+		if (Supported(kernels)) {
+			return kernels;
+		}
+	}
+	return TextKernels::Scalar;
+}
+
+std::atomic<const Kernels*> Active = nullptr;
+
+const Kernels &ActiveKernels() {
+	auto result = Active.load(std::memory_order_acquire);
+	if (!result) {
+		// Concurrent first calls choose the same kernels,
+		// but SetTextKernels() could be called meanwhile.
+		const auto chosen = &kKernels[int(ChooseKernels())];
+		result = Active.compare_exchange_strong(result, chosen)
+			? chosen
+			: result;
+	}
+	return *result;
+}
+
+} // namespace
+
+TextKernels ActiveTextKernels() {
+	return TextKernels(&ActiveKernels() - kKernels.data());
+}
+
+const char *TextKernelsName(TextKernels kernels) {
+	return kKernelsNames[int(kernels)];
+}
+
+std::optional<TextKernels> TextKernelsFromName(const QString &name) {
+	for (auto i = 0; i != int(kKernelsNames.size()); i++) {
+		if (name == QLatin1String(kKernelsNames[i])) {
+			return TextKernels(i);
+		}
+	}
+	return std::nullopt;
+}
+
+bool SetTextKernels(TextKernels kernels) {
+	if (!Supported(kernels)) {
+		return false;
+	}
+	Active.store(&kKernels[int(kernels)], std::memory_order_release);
+	return true;
+}
+
+int AsciiPrefixLength(const QChar *text, int size) {
+	return ActiveKernels().asciiPrefixLength(text, size);
+}
+
+void NarrowAscii(const QChar *text, int size, char *out) {
+	ActiveKernels().narrowAscii(text, size, out);
+}
+
+} // namespace Spellchecker
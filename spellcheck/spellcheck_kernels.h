@@ -0,0 +1,45 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+#include <optional>
+
+namespace Spellchecker {
+
+// Hot text routines have vector variants that are chosen at runtime,
+// so portable builds use the best instructions of the CPU.
+
+enum class TextKernels {
+	Scalar,
+	Sse42,
+	Avx2,
+	Neon,
+};
+
+// Thread: Any.
+// The best supported variant is chosen on the first use, a lower one
+// can be forced by DESKTOP_APP_SPELLCHECK_KERNELS=scalar|sse42|avx2|neon.
+[[nodiscard]] TextKernels ActiveTextKernels();
+[[nodiscard]] const char *TextKernelsName(TextKernels kernels);
+[[nodiscard]] std::optional<TextKernels> TextKernelsFromName(
+	const QString &name);
+
+// Thread: Any.
+// Returns false if the variant is not supported by the CPU or the build.
+bool SetTextKernels(TextKernels kernels);
+
+// Thread: Any.
+[[nodiscard]] int AsciiPrefixLength(const QChar *text, int size);
+[[nodiscard]] inline bool IsAscii(const QChar *text, int size) {
+	return AsciiPrefixLength(text, size) == size;
+}
+
+// Thread: Any.
+// The text should be ASCII, the output should have the size bytes.
+void NarrowAscii(const QChar *text, int size, char *out);
+
+} // namespace Spellchecker
@@ -0,0 +1,124 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "spellcheck/spellcheck_replacements.h"
+
+#include "spellcheck/spellcheck_value.h"
+
+#include <QtCore/QFile>
+
+#include <mutex>
+
+namespace Spellchecker {
+namespace {
+
+constexpr auto kMaxReplacements = 1000;
+constexpr auto kMaxFileSize = 256 * 1024;
+
+struct Replacement {
+	QString typo;
+	QString correction;
+};
+
+std::mutex ReplacementsMutex;
+// The most recent replacements are at the end.
+std::vector<Replacement> Replacements;
+QString LoadedFrom;
+
+QString ReplacementsPath(const QString &workingDir) {
+	return workingDir + "/replacements";
+}
+
+// Each line is "typo\tcorrection" in UTF-8.
+void LoadReplacements(const QString &workingDir) {
+	if (LoadedFrom == workingDir) {
+		return;
+	}
+	LoadedFrom = workingDir;
+	Replacements.clear();
+
+	auto f = QFile(ReplacementsPath(workingDir));
+	if (f.size() > kMaxFileSize || !f.open(QIODevice::ReadOnly)) {
+		return;
+	}
+	for (const auto &line : QString::fromUtf8(f.readAll()).split('\n')) {
+		const auto parts = line.split('\t');
+		if (parts.size() != 2
+			|| parts[0].isEmpty()
+			|| parts[1].isEmpty()) {
+			continue;
+		}
+		Replacements.push_back({ parts[0], parts[1] });
+	}
+	if (Replacements.size() > kMaxReplacements) {
+		Replacements.erase(
+			begin(Replacements),
+			end(Replacements) - kMaxReplacements);
+	}
+}
+
+void SaveReplacements(const QString &workingDir) {
+	auto f = QFile(ReplacementsPath(workingDir));
+	if (!f.open(QIODevice::WriteOnly)) {
+		return;
+	}
+	auto data = QString();
+	for (const auto &replacement : Replacements) {
+		data += replacement.typo + '\t' + replacement.correction + '\n';
+	}
+	f.write(data.toUtf8());
+}
+
+} // namespace
+
+void RememberReplacement(const QString &typo, const QString &correction) {
+	const auto workingDir = WorkingDirPath();
+	if (workingDir.isEmpty()
+		|| typo.isEmpty()
+		|| correction.isEmpty()
+		|| typo.contains('\t')
+		|| correction.contains('\t')
+		|| typo.contains('\n')
+		|| correction.contains('\n')) {
+		return;
+	}
+	crl::async([=] {
+		std::lock_guard lock(ReplacementsMutex);
+		LoadReplacements(workingDir);
+
+		Replacements.erase(ranges::remove_if(Replacements, [&](
+				const Replacement &replacement) {
+			return (replacement.typo == typo)
+				&& (replacement.correction == correction);
+		}), end(Replacements));
+		Replacements.push_back({ typo, correction });
+		if (Replacements.size() > kMaxReplacements) {
+			Replacements.erase(begin(Replacements));
+		}
+		// The file is written under the lock, so it always has
+		// the same replacements as the memory.
+		SaveReplacements(workingDir);
+	});
+}
+
+std::vector<QString> FindReplacements(const QString &typo) {
+	const auto workingDir = WorkingDirPath();
+	if (workingDir.isEmpty() || typo.isEmpty()) {
+		return {};
+	}
+	std::lock_guard lock(ReplacementsMutex);
+	LoadReplacements(workingDir);
+	return ranges::view::all(
+		Replacements
+	) | ranges::views::reverse | ranges::views::filter([&](
+			const Replacement &replacement) {
+		return (replacement.typo == typo);
+	}) | ranges::views::transform(
+		&Replacement::correction
+	) | ranges::to_vector;
+}
+
+} // namespace Spellchecker
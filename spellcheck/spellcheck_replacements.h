@@ -0,0 +1,22 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+namespace Spellchecker {
+
+// Corrections the user picked from suggestions are remembered
+// in "<working dir>/replacements" and offered first for the same typo.
+
+// Thread: Main.
+// Returns immediately, the file is updated in the background.
+void RememberReplacement(const QString &typo, const QString &correction);
+
+// Thread: Any.
+// The most recently picked correction goes first.
+[[nodiscard]] std::vector<QString> FindReplacements(const QString &typo);
+
+} // namespace Spellchecker
@@ -0,0 +1,124 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "spellcheck/spellcheck_stream.h"
+
+#include "spellcheck/platform/platform_spellcheck.h"
+#include "spellcheck/spellcheck_utils.h"
+
+#include <QtCore/QIODevice>
+#include <QtCore/QTextBoundaryFinder>
+#include <QtCore/QTextCodec>
+
+namespace Spellchecker {
+namespace {
+
+constexpr auto kReadChunkSize = 64 * 1024;
+
+// A longer text without whitespaces is cut at a word boundary.
+constexpr auto kMaxPendingSize = 16 * 1024;
+
+// A word boundary depends on the two characters after it at most,
+// so boundaries closer to the end can go away with the next chunk.
+constexpr auto kBoundaryLookahead = 2;
+
+// Returns 0 if the text has no word boundaries.
+int LastWordBoundary(const QString &text) {
+	auto finder = QTextBoundaryFinder(QTextBoundaryFinder::Word, text);
+	finder.setPosition(text.size() - kBoundaryLookahead);
+	const auto result = finder.isAtBoundary()
+		? finder.position()
+		: finder.toPreviousBoundary();
+	return std::max(result, 0);
+}
+
+} // namespace
+
+StreamChecker::StreamChecker(StreamCallback callback)
+: _callback(std::move(callback)) {
+}
+
+void StreamChecker::feed(QStringView chunk) {
+	_pending.append(chunk.data(), chunk.size());
+
+	if (_skipping) {
+		auto length = 0;
+		while (length < _pending.size() && !_pending.at(length).isSpace()) {
+			length++;
+		}
+		if (length > 0) {
+			skip(length);
+		}
+		if (_pending.isEmpty()) {
+			return;
+		}
+		_skipping = false;
+	}
+
+	auto length = _pending.size();
+	while (length > 0 && !_pending.at(length - 1).isSpace()) {
+		length--;
+	}
+	if (length > 0) {
+		check(length);
+	}
+	if (_pending.size() <= kMaxPendingSize) {
+		return;
+	}
+	// The unfinished word after the boundary is kept,
+	// so it is segmented from its start with the next chunk.
+	if (const auto boundary = LastWordBoundary(_pending)) {
+		check(boundary);
+	} else {
+		_skipping = true;
+		skip(_pending.size());
+	}
+}
+
+void StreamChecker::finish() {
+	if (!_pending.isEmpty()) {
+		check(_pending.size());
+	}
+}
+
+void StreamChecker::check(int length) {
+	const auto text = TextPart(_pending, 0, length);
+	Platform::Spellchecker::CheckSpellingText(text, &_ranges);
+	_callback(_offset, text, _ranges, true);
+
+	_pending.remove(0, length);
+	_offset += length;
+}
+
+void StreamChecker::skip(int length) {
+	_callback(
+		_offset,
+		TextPart(_pending, 0, length),
+		MisspelledWords(),
+		false);
+
+	_pending.remove(0, length);
+	_offset += length;
+}
+
+void CheckSpellingStream(
+		not_null<QIODevice*> device,
+		StreamCallback callback) {
+	const auto decoder = std::unique_ptr<QTextDecoder>(
+		QTextCodec::codecForName("UTF-8")->makeDecoder());
+	auto checker = StreamChecker(std::move(callback));
+	auto buffer = QByteArray(kReadChunkSize, Qt::Uninitialized);
+	while (true) {
+		const auto read = device->read(buffer.data(), buffer.size());
+		if (read <= 0) {
+			break;
+		}
+		checker.feed(decoder->toUnicode(buffer.constData(), read));
+	}
+	checker.finish();
+}
+
+} // namespace Spellchecker
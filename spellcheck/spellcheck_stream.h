@@ -0,0 +1,55 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+#include "spellcheck/spellcheck_types.h"
+
+class QIODevice;
+
+namespace Spellchecker {
+
+// Called for each piece of text, even without misspellings.
+// Ranges are relative to the piece,
+// the offset of the piece is counted from the start of the stream
+// in UTF-16 code units. Pieces that were not checked have no ranges.
+// The text is valid only during the call.
+using StreamCallback = Fn<void(
+	int64 offset,
+	QStringView text,
+	const MisspelledWords &ranges,
+	bool checked)>;
+
+// Checks a text that comes in chunks. Only the part after
+// the last whitespace is kept between chunks, so a word
+// is never split by a chunk boundary. A too long run without
+// whitespaces is cut at its last word boundary, and if it has none,
+// it is not checked up to the next whitespace.
+class StreamChecker final {
+public:
+	explicit StreamChecker(StreamCallback callback);
+
+	void feed(QStringView chunk);
+	void finish();
+
+private:
+	void check(int length);
+	void skip(int length);
+
+	const StreamCallback _callback;
+	QString _pending;
+	MisspelledWords _ranges;
+	int64 _offset = 0;
+	bool _skipping = false;
+
+};
+
+// Reads the device in UTF-8 until its end.
+void CheckSpellingStream(
+	not_null<QIODevice*> device,
+	StreamCallback callback);
+
+} // namespace Spellchecker
@@ -0,0 +1,126 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "spellcheck/spellcheck_trace.h"
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace Spellchecker {
+namespace {
+
+constexpr auto kMaxSpans = 16384;
+static_assert(!(kMaxSpans & (kMaxSpans - 1)));
+
+// A writer marks the slot with an odd sequence number while it fills
+// the slot, so a reader skips the slots that are being written.
+struct Slot {
+	std::atomic<uint64> sequence = 0;
+	std::atomic<const char*> name = nullptr;
+	std::atomic<int64> start = 0;
+	std::atomic<int64> duration = 0;
+	std::atomic<uint64> thread = 0;
+};
+
+std::atomic<bool> Enabled = false;
+std::atomic<uint64> Head = 0;
+std::array<Slot, kMaxSpans> Slots;
+
+int64 NowMicroseconds() {
+	using namespace std::chrono;
+	return duration_cast<microseconds>(
+		steady_clock::now().time_since_epoch()).count();
+}
+
+uint64 CurrentThreadId() {
+	return std::hash<std::thread::id>()(std::this_thread::get_id());
+}
+
+void Record(const char *name, int64 start, int64 duration) {
+	const auto index = Head.fetch_add(1, std::memory_order_relaxed);
+	auto &slot = Slots[index & (kMaxSpans - 1)];
+	slot.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.name.store(name, std::memory_order_relaxed);
+	slot.start.store(start, std::memory_order_relaxed);
+	slot.duration.store(duration, std::memory_order_relaxed);
+	slot.thread.store(CurrentThreadId(), std::memory_order_relaxed);
+	slot.sequence.store(index * 2 + 2, std::memory_order_release);
+}
+
+} // namespace
+
+void SetTraceEnabled(bool enabled) {
+	Enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool TraceEnabled() {
+	return Enabled.load(std::memory_order_relaxed);
+}
+
+void ClearTrace() {
+	for (auto &slot : Slots) {
+		slot.sequence.store(0, std::memory_order_relaxed);
+	}
+}
+
+QByteArray TraceToJson() {
+	// Thread ids are hashed, so we number them in order of appearance.
+	auto threads = std::vector<uint64>();
+	auto events = QJsonArray();
+	for (auto &slot : Slots) {
+		const auto sequence = slot.sequence.load(std::memory_order_acquire);
+		if (!sequence || (sequence & 1)) {
+			continue;
+		}
+		const auto name = slot.name.load(std::memory_order_relaxed);
+		const auto start = slot.start.load(std::memory_order_relaxed);
+		const auto duration = slot.duration.load(std::memory_order_relaxed);
+		const auto thread = slot.thread.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+			continue;
+		}
+		auto tid = ranges::find(threads, thread) - begin(threads);
+		if (tid == threads.size()) {
+			threads.push_back(thread);
+		}
+		events.append(QJsonObject{
+			{ "name", QString::fromLatin1(name) },
+			{ "cat", "spellcheck" },
+			{ "ph", "X" },
+			{ "ts", double(start) },
+			{ "dur", double(duration) },
+			{ "pid", 1 },
+			{ "tid", int(tid) },
+		});
+	}
+	return QJsonDocument(QJsonObject{
+		{ "traceEvents", events },
+		{ "displayTimeUnit", "ms" },
+	}).toJson(QJsonDocument::Compact);
+}
+
+TraceSpan::TraceSpan(const char *name) {
+	if (TraceEnabled()) {
+		_name = name;
+		_start = NowMicroseconds();
+	}
+}
+
+TraceSpan::~TraceSpan() {
+	if (_name) {
+		Record(_name, _start, NowMicroseconds() - _start);
+	}
+}
+
+} // namespace Spellchecker
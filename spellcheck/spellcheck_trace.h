@@ -0,0 +1,39 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+namespace Spellchecker {
+
+// Spans of the spellchecking pipeline are recorded to a fixed ring buffer
+// only while the tracing is enabled, the oldest spans are overwritten.
+
+// Thread: Any.
+void SetTraceEnabled(bool enabled);
+[[nodiscard]] bool TraceEnabled();
+void ClearTrace();
+
+// Thread: Any.
+// Chrome trace event format, it can be opened in Perfetto UI
+// or chrome://tracing.
+[[nodiscard]] QByteArray TraceToJson();
+
+class TraceSpan final {
+public:
+	// The name should be a string literal, it is not copied.
+	explicit TraceSpan(const char *name);
+	~TraceSpan();
+
+	TraceSpan(const TraceSpan &) = delete;
+	TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+	const char *_name = nullptr;
+	int64 _start = 0;
+
+};
+
+} // namespace Spellchecker
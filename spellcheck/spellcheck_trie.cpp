@@ -0,0 +1,154 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "spellcheck/spellcheck_trie.h"
+
+namespace Spellchecker {
+namespace {
+
+// Keeps the completion of short prefixes within a fraction of millisecond.
+constexpr auto kMaxVisitedNodes = 20000;
+
+} // namespace
+
+WordTrie::WordTrie(std::vector<QString> words) {
+	words = std::move(
+		words
+	) | ranges::actions::sort | ranges::actions::unique;
+	words.erase(ranges::remove(words, QString()), end(words));
+
+	_nodes.emplace_back();
+	build(words, 0, 0, words.size(), 0);
+	_nodes.shrink_to_fit();
+}
+
+void WordTrie::build(
+		const std::vector<QString> &words,
+		int index,
+		int from,
+		int till,
+		int depth) {
+	// Words are sorted, so the word that ends here is the first one.
+	if (from < till && words[from].size() == depth) {
+		_nodes[index].terminal = true;
+		from++;
+	}
+	if (from == till) {
+		return;
+	}
+
+	const auto firstChild = int(_nodes.size());
+	auto bounds = std::vector<int>{ from };
+	for (auto i = from; i < till; i++) {
+		const auto c = words[i].at(depth);
+		if (i > from && c != words[i - 1].at(depth)) {
+			bounds.push_back(i);
+		}
+		if (bounds.back() == i) {
+			auto node = Node();
+			node.character = c.unicode();
+			_nodes.push_back(node);
+		}
+	}
+	bounds.push_back(till);
+
+	_nodes[index].firstChild = firstChild;
+	_nodes[index].childrenCount = bounds.size() - 1;
+	for (auto i = 0; i < bounds.size() - 1; i++) {
+		build(words, firstChild + i, bounds[i], bounds[i + 1], depth + 1);
+	}
+}
+
+bool WordTrie::empty() const {
+	return _nodes.empty() || !_nodes.front().childrenCount;
+}
+
+int WordTrie::child(int index, QChar c) const {
+	const auto &node = _nodes[index];
+	const auto from = begin(_nodes) + node.firstChild;
+	const auto till = from + node.childrenCount;
+	const auto it = std::lower_bound(from, till, c.unicode(), [](
+			const Node &node,
+			ushort character) {
+		return node.character < character;
+	});
+	return (it != till && it->character == c.unicode())
+		? int(it - begin(_nodes))
+		: -1;
+}
+
+int WordTrie::find(QStringView prefix) const {
+	if (_nodes.empty()) {
+		return -1;
+	}
+	auto index = 0;
+	for (auto i = 0; i < prefix.size() && index >= 0; i++) {
+		index = child(index, prefix.at(i));
+	}
+	return index;
+}
+
+bool WordTrie::contains(QStringView word) const {
+	const auto index = find(word);
+	return (index >= 0) && _nodes[index].terminal;
+}
+
+int WordTrie::longestMatch(const QChar *text, int size) const {
+	auto result = 0;
+	auto index = _nodes.empty() ? -1 : 0;
+	for (auto i = 0; i < size && index >= 0;) {
+		index = child(index, text[i++]);
+		if (index >= 0
+			&& _nodes[index].terminal
+			&& (i == size || !text[i].isMark())) {
+			result = i;
+		}
+	}
+	return result;
+}
+
+std::vector<QString> WordTrie::complete(
+		QStringView prefix,
+		int limit) const {
+	auto result = std::vector<QString>();
+	const auto root = find(prefix);
+	if (root < 0 || limit <= 0) {
+		return result;
+	}
+
+	// The breadth-first walk finds shorter words first.
+	struct Entry {
+		int node = 0;
+		int parent = -1;
+	};
+	auto queue = std::vector<Entry>{ { root, -1 } };
+	const auto wordAt = [&](int entry) {
+		auto suffix = QString();
+		for (; queue[entry].parent >= 0; entry = queue[entry].parent) {
+			suffix.push_back(QChar(_nodes[queue[entry].node].character));
+		}
+		std::reverse(suffix.begin(), suffix.end());
+		return QString(prefix.data(), prefix.size()) + suffix;
+	};
+	for (auto i = 0; i < queue.size(); i++) {
+		const auto &node = _nodes[queue[i].node];
+		if (node.terminal) {
+			result.push_back(wordAt(i));
+			if (result.size() == limit) {
+				break;
+			}
+		}
+		if (queue.size() >= kMaxVisitedNodes) {
+			continue;
+		}
+		for (auto j = 0; j < node.childrenCount; j++) {
+			queue.push_back({ int(node.firstChild + j), i });
+		}
+	}
+	return result;
+}
+
+} // namespace Spellchecker
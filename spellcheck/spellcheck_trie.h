@@ -0,0 +1,54 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+#include "spellcheck/spellcheck_types.h"
+
+namespace Spellchecker {
+
+// Immutable trie of dictionary words stored in one flat array.
+// Children of a node are kept together and sorted,
+// so a lookup is a binary search on each level.
+class WordTrie final {
+public:
+	WordTrie() = default;
+	explicit WordTrie(std::vector<QString> words);
+
+	[[nodiscard]] bool empty() const;
+	[[nodiscard]] bool contains(QStringView word) const;
+
+	// Length of the longest word at the start of the text,
+	// or 0 if there is none. A word can't end before a combining mark.
+	[[nodiscard]] int longestMatch(const QChar *text, int size) const;
+
+	// Shorter words go first, words of the same length are sorted.
+	[[nodiscard]] std::vector<QString> complete(
+		QStringView prefix,
+		int limit) const;
+
+private:
+	struct Node {
+		uint32 firstChild = 0;
+		ushort childrenCount = 0;
+		ushort character = 0;
+		bool terminal = false;
+	};
+
+	void build(
+		const std::vector<QString> &words,
+		int index,
+		int from,
+		int till,
+		int depth);
+	[[nodiscard]] int child(int index, QChar c) const;
+	[[nodiscard]] int find(QStringView prefix) const;
+
+	std::vector<Node> _nodes;
+
+};
+
+} // namespace Spellchecker
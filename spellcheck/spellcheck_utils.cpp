@@ -6,10 +6,19 @@
 //
 #include "spellcheck/spellcheck_utils.h"
 #include "spellcheck/platform/platform_spellcheck.h"
+#include "spellcheck/spellcheck_autocorrect.h"
+#include "spellcheck/spellcheck_kernels.h"
+#include "spellcheck/spellcheck_trace.h"
+#include "spellcheck/spellcheck_trie.h"
 
+#include <QtCore/QHash>
 #include <QtCore/QStringList>
 #include <QTextBoundaryFinder>
 
+#include <atomic>
+#include <map>
+#include <mutex>
+
 namespace Spellchecker {
 namespace {
 
@@ -27,6 +36,25 @@ constexpr auto kFactor = 1000;
 
 constexpr auto kMaxWordSize = 99;
 
+constexpr auto kMaxCachedVerdicts = 20000;
+constexpr auto kMaxSpeculativeVerdicts = 64;
+
+QHash<QString, bool> Verdicts;
+// Verdicts of the words being typed, most of them are never finished,
+// so they are kept apart and don't push the real words out.
+QHash<QString, bool> SpeculativeVerdicts;
+std::atomic<int> VerdictsGeneration = 0;
+std::atomic<int64> VerdictHits = 0;
+std::atomic<int64> VerdictMisses = 0;
+std::mutex VerdictsMutex;
+
+std::atomic<int> ShadowSampling = 0;
+std::atomic<uint64> ShadowTexts = 0;
+std::atomic<int64> ShadowVerified = 0;
+std::atomic<int64> ShadowMismatches = 0;
+std::atomic<int64> ShadowMismatchedWords = 0;
+thread_local bool ReferenceRunning = false;
+
 constexpr auto kAcuteAccentChars = {
 	QChar(769),	QChar(833),	// QChar(180),
 	QChar(714),	QChar(779),	QChar(733),
@@ -205,6 +233,135 @@ inline auto IsSpellcheckableScripts(const QChar::Script &s) {
 	return !ranges::contains(kUnspellcheckableScripts, s);
 }
 
+const auto kSegmentedScripts = {
+	QChar::Script_Thai,
+	QChar::Script_Lao,
+	QChar::Script_Khmer,
+	QChar::Script_Myanmar,
+};
+
+std::mutex SegmentationMutex;
+std::map<
+	QChar::Script,
+	std::vector<std::weak_ptr<const WordTrie>>> SegmentationWords;
+std::atomic<bool> HasSegmentationWords = false;
+
+using SegmentationTries = std::vector<std::shared_ptr<const WordTrie>>;
+
+// Words of all the engines of the script that are still alive.
+SegmentationTries SegmentationWordsFor(QChar::Script script) {
+	if (!HasSegmentationWords
+		|| !ranges::contains(kSegmentedScripts, script)) {
+		return {};
+	}
+	std::lock_guard lock(SegmentationMutex);
+	const auto it = SegmentationWords.find(script);
+	if (it == end(SegmentationWords)) {
+		return {};
+	}
+	auto result = SegmentationTries();
+	for (const auto &weak : it->second) {
+		if (auto words = weak.lock()) {
+			result.push_back(std::move(words));
+		}
+	}
+	return result;
+}
+
+// The longest word of any of the dictionaries.
+int LongestMatch(
+		const SegmentationTries &tries,
+		const QChar *data,
+		int length) {
+	auto result = 0;
+	for (const auto &words : tries) {
+		result = std::max(result, words->longestMatch(data, length));
+	}
+	return result;
+}
+
+template <typename Callback>
+void SplitByDictionary(const QChar *data, int length, Callback &&callback) {
+	const auto tries = (length > 1)
+		? SegmentationWordsFor(data[0].script())
+		: SegmentationTries();
+	if (tries.empty()) {
+		callback(0, length);
+		return;
+	}
+	for (auto i = 0; i < length;) {
+		if (const auto match = LongestMatch(tries, data + i, length - i)) {
+			callback(i, match);
+			i += match;
+			continue;
+		}
+		// Characters up to the next known word are checked as one word.
+		auto j = i + 1;
+		while (j < length
+			&& (data[j].isMark()
+				|| !LongestMatch(tries, data + j, length - j))) {
+			j++;
+		}
+		callback(i, j - i);
+		i = j;
+	}
+}
+
+// The same way as words are read in RangesFromText().
+template <typename Callback>
+void EnumerateWords(
+		QTextBoundaryFinder &finder,
+		const QChar *data,
+		int textLength,
+		Callback &&callback) {
+	const auto isEnd = [&] {
+		return (finder.toNextBoundary() == -1);
+	};
+
+	while (finder.position() < textLength) {
+		if (!finder.boundaryReasons().testFlag(
+				QTextBoundaryFinder::StartOfItem)) {
+			if (isEnd()) {
+				break;
+			}
+			continue;
+		}
+
+		const auto start = finder.position();
+		const auto end = finder.toNextBoundary();
+		if (end == -1) {
+			break;
+		}
+		const auto length = end - start;
+		if (length < 1) {
+			continue;
+		}
+		SplitByDictionary(data + start, length, [&](int from, int size) {
+			callback(start + from, size);
+		});
+
+		if (isEnd()) {
+			break;
+		}
+	}
+}
+
+// A whitespace followed by a letter is a word boundary
+// regardless of the rest of the text.
+int SafeBoundaryAfter(const QString &text, int position) {
+	for (auto i = std::max(position, 1); i < text.size(); i++) {
+		if (text.at(i - 1).isSpace() && text.at(i).isLetterOrNumber()) {
+			return i;
+		}
+	}
+	return text.size();
+}
+
+thread_local std::vector<QString> CurrentLanguageHint;
+// The empty hint of each thread has the generation 0.
+thread_local uint64 CurrentLanguageHintGeneration = 0;
+std::atomic<uint64> LanguageHintGenerations = 0;
+
 } // namespace
 
 QChar::Script LocaleToScriptCode(const QString &locale) {
@@ -232,6 +389,26 @@ bool IsWordSkippable(const QStringRef &word, bool checkSupportedScripts) {
 	if (word.size() > kMaxWordSize) {
 		return true;
 	}
+	// ASCII letters are Latin and the rest is Common,
+	// so the script table isn't needed for every character.
+	if (!ReferenceRunning && IsAscii(word.data(), word.size())) {
+		const auto isLetter = [](QChar c) {
+			return (c.unicode() >= 'a' && c.unicode() <= 'z')
+				|| (c.unicode() >= 'A' && c.unicode() <= 'Z');
+		};
+		const auto latin = ranges::any_of(word, isLetter);
+		if (checkSupportedScripts
+			&& !ranges::contains(
+				SupportedScripts,
+				latin ? QChar::Script_Latin : QChar::Script_Common)) {
+			return true;
+		}
+		return latin && ranges::any_of(word, [&](QChar c) {
+			return !isLetter(c)
+				&& (c.unicode() != '\'')
+				&& (c.unicode() != '_');
+		});
+	}
 	const auto wordScript = WordScript(word);
 	if (checkSupportedScripts
 		&& !ranges::contains(SupportedScripts, wordScript)) {
@@ -247,6 +424,8 @@ bool IsWordSkippable(const QStringRef &word, bool checkSupportedScripts) {
 
 void UpdateSupportedScripts(std::vector<QString> languages) {
 	// It should be called at least once from Platform::Spellchecker::Init().
+	ClearVerdictCache();
+	UpdateAutocorrectLanguages(languages);
 	SupportedScripts = ranges::view::all(
 		languages
 	) | ranges::views::transform(
@@ -265,49 +444,316 @@ MisspelledWords RangesFromText(
 	const QString &text,
 	Fn<bool(const QString &word)> filterCallback) {
 	MisspelledWords ranges;
+	RangesFromText(text, std::move(filterCallback), &ranges);
+	return ranges;
+}
 
-	if (text.isEmpty()) {
-		return ranges;
+void RangesFromText(
+		QStringView text,
+		Fn<bool(const QString &word)> filterCallback,
+		not_null<MisspelledWords*> ranges) {
+	ranges->clear();
+	if (!text.size()) {
+		return;
 	}
 
-	auto finder = QTextBoundaryFinder(QTextBoundaryFinder::Word, text);
+	const auto span = TraceSpan("RangesFromText");
+	// If the callback keeps a copy of the word,
+	// the buffer is detached on the next word.
+	// The buffer is taken for the call, so a nested call from
+	// the callback finds it empty instead of overwriting the word.
+	thread_local auto buffer = QString();
+	auto word = std::move(buffer);
+	auto finder = QTextBoundaryFinder(
+		QTextBoundaryFinder::Word,
+		text.data(),
+		text.size());
+	EnumerateWords(
+			finder,
+			text.data(),
+			text.size(),
+			[&](int start, int length) {
+		word.resize(0);
+		word.append(text.data() + start, length);
+		if (!filterCallback(word)) {
+			ranges->push_back(std::make_pair(start, length));
+		}
+	});
+	buffer = std::move(word);
+}
 
-	const auto isEnd = [&] {
-		return (finder.toNextBoundary() == -1);
+void SegmentedText::reset(const QString &text) {
+	_words.clear();
+	segment(text, 0, text.size());
+}
+
+const MisspelledWords &SegmentedText::words() const {
+	return _words;
+}
+
+MisspelledWords SegmentedText::wordsBetween(int from, int till) const {
+	const auto first = ranges::find_if(_words, [&](const auto &word) {
+		return word.first + word.second >= from;
+	});
+	const auto last = std::find_if(first, end(_words), [&](const auto &word) {
+		return word.first > till;
+	});
+	return MisspelledWords(first, last);
+}
+
+void SegmentedText::segment(const QString &text, int from, int till) {
+	if (from >= till) {
+		return;
+	}
+	auto finder = QTextBoundaryFinder(
+		QTextBoundaryFinder::Word,
+		text.constData() + from,
+		till - from);
+	EnumerateWords(
+			finder,
+			text.constData() + from,
+			till - from,
+			[&](int start, int length) {
+		_words.emplace_back(from + start, length);
+	});
+}
+
+MisspelledWord SegmentedText::update(
+		const QString &text,
+		int position,
+		int removed,
+		int added) {
+	const auto endOfWord = [](const MisspelledWord &word) {
+		return word.first + word.second;
 	};
+	const auto shift = added - removed;
+	const auto editEnd = position + added;
 
-	while (finder.position() < text.length()) {
-		if (!finder.boundaryReasons().testFlag(
-				QTextBoundaryFinder::StartOfItem)) {
-			if (isEnd()) {
-				break;
-			}
-			continue;
-		}
+	// The start of the word before the edit is not affected by it,
+	// so the segmentation is resumed from there.
+	const auto first = ranges::find_if(_words, [&](const auto &word) {
+		return endOfWord(word) >= position;
+	}) - begin(_words);
+	const auto kept = std::max(int(first) - 1, 0);
+	const auto from = (first > 0) ? _words[kept].first : 0;
 
-		const auto start = finder.position();
-		const auto end = finder.toNextBoundary();
-		if (end == -1) {
+	// Words after the edit are moved to their new positions.
+	auto tail = ranges::find_if(_words, [&](const auto &word) {
+		return word.first >= position + removed;
+	}) - begin(_words);
+	for (auto i = tail; i < _words.size(); i++) {
+		_words[i].first += shift;
+	}
+	auto oldTail = MisspelledWords(begin(_words) + tail, end(_words));
+	_words.erase(begin(_words) + kept, end(_words));
+
+	// Segment up to a certain boundary after the edit until
+	// a word there starts exactly where one of the old words starts.
+	auto windowFrom = std::min(from, text.size());
+	auto windowTill = SafeBoundaryAfter(text, editEnd);
+	auto resynced = oldTail.end();
+	while (true) {
+		segment(text, windowFrom, windowTill);
+		const auto it = ranges::lower_bound(
+			oldTail,
+			windowTill,
+			ranges::less(),
+			&MisspelledWord::first);
+		if (windowTill >= text.size()) {
+			break;
+		} else if (it != oldTail.end() && it->first == windowTill) {
+			resynced = it;
 			break;
 		}
-		const auto length = end - start;
-		if (length < 1) {
-			continue;
-		}
-		if (!filterCallback(text.mid(start, length))) {
-			ranges.push_back(std::make_pair(start, length));
+		windowFrom = windowTill;
+		windowTill = SafeBoundaryAfter(text, windowTill + 1);
+	}
+	ranges::copy(resynced, oldTail.end(), ranges::back_inserter(_words));
+	return { from, windowTill - from };
+}
+
+bool CheckSkipAndSpell(const QString &word) {
+	const auto skip = [&] {
+		const auto span = TraceSpan("skip_filter");
+		return IsWordSkippable(&word);
+	}();
+	return !skip && CheckCachedSpelling(word);
+}
+
+bool CheckCachedSpelling(const QString &word) {
+	const auto generation = VerdictsGeneration.load();
+	if (const auto verdict = CachedVerdict(word)) {
+		VerdictHits++;
+		return *verdict;
+	}
+	VerdictMisses++;
+	const auto result = Platform::Spellchecker::CheckSpelling(word);
+
+	std::lock_guard lock(VerdictsMutex);
+	// The verdict may be outdated if the cache was cleared
+	// while the word was being checked.
+	if (generation == VerdictsGeneration.load()) {
+		if (Verdicts.size() >= kMaxCachedVerdicts) {
+			Verdicts.clear();
 		}
+		Verdicts.insert(word, result);
+	}
+	return result;
+}
 
-		if (isEnd()) {
-			break;
+std::optional<bool> CachedVerdict(const QString &word) {
+	std::lock_guard lock(VerdictsMutex);
+	const auto it = Verdicts.constFind(word);
+	if (it != Verdicts.cend()) {
+		return *it;
+	}
+	// The word is finished, so its speculative verdict is kept for good.
+	const auto speculative = SpeculativeVerdicts.find(word);
+	if (speculative == SpeculativeVerdicts.end()) {
+		return std::nullopt;
+	}
+	const auto result = *speculative;
+	SpeculativeVerdicts.erase(speculative);
+	if (Verdicts.size() >= kMaxCachedVerdicts) {
+		Verdicts.clear();
+	}
+	Verdicts.insert(word, result);
+	return result;
+}
+
+bool HasVerdict(const QString &word) {
+	std::lock_guard lock(VerdictsMutex);
+	return Verdicts.contains(word) || SpeculativeVerdicts.contains(word);
+}
+
+void CheckSpellingSpeculatively(const QString &word) {
+	const auto generation = VerdictsGeneration.load();
+	if (HasVerdict(word)) {
+		return;
+	}
+	const auto result = Platform::Spellchecker::CheckSpelling(word);
+
+	std::lock_guard lock(VerdictsMutex);
+	if (generation == VerdictsGeneration.load()) {
+		if (SpeculativeVerdicts.size() >= kMaxSpeculativeVerdicts) {
+			SpeculativeVerdicts.clear();
 		}
+		SpeculativeVerdicts.insert(word, result);
 	}
-	return ranges;
 }
 
-bool CheckSkipAndSpell(const QString &word) {
-	return !IsWordSkippable(&word)
-		&& Platform::Spellchecker::CheckSpelling(word);
+LanguageHint::LanguageHint(std::vector<QString> languages)
+: _previous(std::exchange(CurrentLanguageHint, std::move(languages)))
+, _previousGeneration(std::exchange(
+	CurrentLanguageHintGeneration,
+	CurrentLanguageHint.empty() ? 0 : ++LanguageHintGenerations)) {
+}
+
+LanguageHint::~LanguageHint() {
+	CurrentLanguageHint = std::move(_previous);
+	CurrentLanguageHintGeneration = _previousGeneration;
+}
+
+int LanguageHint::Priority(const QString &language) {
+	const auto &hint = CurrentLanguageHint;
+	const auto it = ranges::find_if(hint, [&](const QString &hinted) {
+		return (language == hinted)
+			|| (language.startsWith(hinted)
+				&& language.size() > hinted.size()
+				&& language.at(hinted.size()) == '_');
+	});
+	return int(it - begin(hint));
+}
+
+bool IsSegmentedScript(QChar::Script script) {
+	return ranges::contains(kSegmentedScripts, script);
+}
+
+void AddSegmentationWords(
+		QChar::Script script,
+		std::weak_ptr<const WordTrie> words) {
+	if (!IsSegmentedScript(script)) {
+		return;
+	}
+	std::lock_guard lock(SegmentationMutex);
+	auto &list = SegmentationWords[script];
+	list.erase(ranges::remove_if(list, [](const auto &weak) {
+		return weak.expired();
+	}), end(list));
+	list.push_back(std::move(words));
+	HasSegmentationWords = true;
+}
+
+std::vector<QString> LanguageHint::Current() {
+	return CurrentLanguageHint;
+}
+
+bool LanguageHint::Empty() {
+	return CurrentLanguageHint.empty();
+}
+
+uint64 LanguageHint::Generation() {
+	return CurrentLanguageHintGeneration;
+}
+
+VerdictCacheStats GetVerdictCacheStats() {
+	std::lock_guard lock(VerdictsMutex);
+	auto result = VerdictCacheStats();
+	result.hits = VerdictHits.load();
+	result.misses = VerdictMisses.load();
+	result.size = Verdicts.size();
+	return result;
+}
+
+void SetShadowVerification(int oneOfTexts) {
+	ShadowSampling = std::max(oneOfTexts, 0);
+}
+
+ShadowVerificationStats GetShadowVerificationStats() {
+	auto result = ShadowVerificationStats();
+	result.verified = ShadowVerified.load();
+	result.mismatches = ShadowMismatches.load();
+	result.mismatchedWords = ShadowMismatchedWords.load();
+	return result;
+}
+
+void VerifyCheckResult(QStringView text, const MisspelledWords &result) {
+	const auto sampling = ShadowSampling.load(std::memory_order_relaxed);
+	if (!sampling || ReferenceRunning || (ShadowTexts++ % sampling)) {
+		return;
+	}
+	const auto span = TraceSpan("shadow_verification");
+	auto reference = MisspelledWords();
+	ReferenceRunning = true;
+	RangesFromText(text, [](const QString &word) {
+		return !IsWordSkippable(&word)
+			&& Platform::Spellchecker::CheckSpelling(word);
+	}, &reference);
+	ReferenceRunning = false;
+
+	ShadowVerified++;
+	if (reference != result) {
+		auto difference = MisspelledWords();
+		std::set_symmetric_difference(
+			begin(reference),
+			end(reference),
+			begin(result),
+			end(result),
+			std::back_inserter(difference));
+		ShadowMismatches++;
+		ShadowMismatchedWords += difference.size();
+	}
+}
+
+bool ReferenceCheckRunning() {
+	return ReferenceRunning;
+}
+
+void ClearVerdictCache() {
+	std::lock_guard lock(VerdictsMutex);
+	VerdictsGeneration++;
+	Verdicts.clear();
+	SpeculativeVerdicts.clear();
 }
 
 QLocale LocaleFromLangId(int langId) {
@@ -18,13 +18,143 @@ bool IsWordSkippable(
 	const QStringRef &word,
 	bool checkSupportedScripts = true);
 
+// The part of the text without a copy, clamped to the text.
+// Qt older than 5.10 has no views, so there the part is copied.
+[[nodiscard]] inline auto TextPart(
+		const QString &text,
+		int position,
+		int length) {
+	const auto from = std::clamp(position, 0, int(text.size()));
+	const auto till = std::clamp(position + length, from, int(text.size()));
+#if QT_VERSION < QT_VERSION_CHECK(5, 10, 0)
+	return text.mid(from, till - from);
+#else // Qt < 5.10
+	return QStringView(text).mid(from, till - from);
+#endif // Qt < 5.10
+}
+
 MisspelledWords RangesFromText(
 	const QString &text,
 	Fn<bool(const QString &word)> filterCallback);
+// Reuses the capacity of the ranges and of the word buffer,
+// so the steady state check doesn't allocate.
+// A filter that checks a text again gets its own buffer.
+void RangesFromText(
+	QStringView text,
+	Fn<bool(const QString &word)> filterCallback,
+	not_null<MisspelledWords*> ranges);
+
+// Word ranges of a text that is segmented again after an edit
+// only from the word before the edit until the segmentation
+// meets the old one, instead of the whole text.
+class SegmentedText final {
+public:
+	void reset(const QString &text);
+
+	// Returns the range that was segmented again.
+	MisspelledWord update(
+		const QString &text,
+		int position,
+		int removed,
+		int added);
+
+	[[nodiscard]] const MisspelledWords &words() const;
+	// Words that intersect or touch the range.
+	[[nodiscard]] MisspelledWords wordsBetween(int from, int till) const;
+
+private:
+	void segment(const QString &text, int from, int till);
+
+	MisspelledWords _words;
 
-// For Linux and macOS, which use RangesFromText.
+};
+
+class WordTrie;
+
+// Thread: Any.
+// Thai, Lao, Khmer and Myanmar don't separate words with spaces,
+// so their words are split by the longest match with dictionary words.
+// Only a weak reference is kept, the trie is owned by its engine.
+// Words of several engines of a script are used together,
+// the longest match of any of them is taken.
+[[nodiscard]] bool IsSegmentedScript(QChar::Script script);
+void AddSegmentationWords(
+	QChar::Script script,
+	std::weak_ptr<const WordTrie> words);
+
+// For backends that use RangesFromText.
 bool CheckSkipAndSpell(const QString &word);
 
+// Results of the engine checks are shared by all the fields.
+// The cache is dropped when languages or custom words change.
+[[nodiscard]] bool CheckCachedSpelling(const QString &word);
+[[nodiscard]] std::optional<bool> CachedVerdict(const QString &word);
+void ClearVerdictCache();
+
+// A word that is still being typed is checked into a small separate
+// cache, CachedVerdict() moves its verdict to the shared one when
+// the word is finished. HasVerdict() looks into both without moving.
+void CheckSpellingSpeculatively(const QString &word);
+[[nodiscard]] bool HasVerdict(const QString &word);
+
+struct VerdictCacheStats {
+	int64 hits = 0;
+	int64 misses = 0;
+	int size = 0;
+};
+[[nodiscard]] VerdictCacheStats GetVerdictCacheStats();
+
+// Thread: Any.
+// Shadow verification: one of every N checked texts is checked again
+// by the reference path, each word from RangesFromText goes to the engines
+// without the verdict cache and other shortcuts, and the results are
+// compared. Zero disables it, which is the default.
+void SetShadowVerification(int oneOfTexts);
+
+struct ShadowVerificationStats {
+	int64 verified = 0;
+	int64 mismatches = 0;
+	// Ranges found only by one of the paths.
+	int64 mismatchedWords = 0;
+};
+[[nodiscard]] ShadowVerificationStats GetShadowVerificationStats();
+
+// Thread: Any.
+// For backends that use RangesFromText, with the optimized result.
+void VerifyCheckResult(QStringView text, const MisspelledWords &result);
+
+// Thread: Any.
+// Shortcuts of the engines should be skipped while it is true.
+[[nodiscard]] bool ReferenceCheckRunning();
+
+// Thread: Any.
+// While the hint is alive, checks on the current thread probe
+// the engines of the hinted languages first.
+// It changes only the order of engines, not the verdicts.
+class LanguageHint final {
+public:
+	explicit LanguageHint(std::vector<QString> languages);
+	~LanguageHint();
+
+	LanguageHint(const LanguageHint &) = delete;
+	LanguageHint &operator=(const LanguageHint &) = delete;
+
+	// The hint "ru" matches the language "ru_RU".
+	// Languages that are not hinted have the lowest priority.
+	[[nodiscard]] static int Priority(const QString &language);
+	[[nodiscard]] static std::vector<QString> Current();
+	[[nodiscard]] static bool Empty();
+
+	// Differs for different hints, so the engines can be sorted
+	// once for each hint instead of once for each word.
+	[[nodiscard]] static uint64 Generation();
+
+private:
+	std::vector<QString> _previous;
+	uint64 _previousGeneration = 0;
+
+};
+
 QLocale LocaleFromLangId(int langId);
 
 void UpdateSupportedScripts(std::vector<QString> languages);
@@ -0,0 +1,162 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "spellcheck/spellcheck_warmup.h"
+
+#include "spellcheck/spellcheck_value.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+
+#include <atomic>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif // Q_OS_LINUX
+
+namespace Spellchecker {
+namespace {
+
+constexpr auto kMaxProfileSize = 4 * 1024;
+constexpr auto kTouchChunkSize = 256 * 1024;
+
+// Files of the custom dictionary are read with the first languages.
+const auto kCustomFiles = {
+	"custom",
+	"custom.log",
+};
+
+struct Region {
+	QString path;
+	int64 size = 0;
+
+	friend inline bool operator==(const Region &a, const Region &b) {
+		return (a.path == b.path) && (a.size == b.size);
+	}
+};
+
+std::atomic<bool> PrefetchStarted = false;
+std::atomic<bool> LoadStarted = false;
+
+QString ProfilePath(const QString &workingDir) {
+	return workingDir + "/warmup";
+}
+
+// Paths are relative to the working dir.
+std::vector<Region> ReadProfile(const QString &workingDir) {
+	auto f = QFile(ProfilePath(workingDir));
+	if (f.size() > kMaxProfileSize || !f.open(QIODevice::ReadOnly)) {
+		return {};
+	}
+	auto result = std::vector<Region>();
+	for (const auto &line : QString::fromUtf8(f.readAll()).split('\n')) {
+		const auto parts = line.split('\t');
+		if (parts.size() != 2) {
+			continue;
+		}
+		auto region = Region{ parts[0], parts[1].toLongLong() };
+
+		// The path is read from a file, so keep it sane.
+		if (!region.path.isEmpty()
+			&& !region.path.startsWith('/')
+			&& !region.path.contains('\\')
+			&& !region.path.contains("..")
+			&& region.size > 0) {
+			result.push_back(std::move(region));
+		}
+	}
+	return result;
+}
+
+std::vector<Region> UsedRegions(
+		const QString &workingDir,
+		const std::vector<QString> &languages) {
+	auto paths = std::vector<QString>();
+	for (const auto &lang : languages) {
+		const auto base = QString("%1/%1").arg(lang);
+		paths.push_back(base + ".aff");
+		paths.push_back(base + ".dic");
+	}
+	for (const auto path : kCustomFiles) {
+		paths.push_back(QString(path));
+	}
+	auto result = std::vector<Region>();
+	for (auto &path : paths) {
+		const auto size = QFileInfo(workingDir + '/' + path).size();
+		if (size > 0) {
+			result.push_back({ std::move(path), size });
+		}
+	}
+	return result;
+}
+
+void Prefetch(const QString &path, int64 size) {
+	auto f = QFile(path);
+	if (!f.open(QIODevice::ReadOnly)) {
+		return;
+	}
+	size = std::min(size, f.size());
+#ifdef Q_OS_LINUX
+	// The kernel reads the file ahead without copying it to us.
+	if (!posix_fadvise(f.handle(), 0, size, POSIX_FADV_WILLNEED)) {
+		return;
+	}
+#endif // Q_OS_LINUX
+	// Reading along with the engines would only compete with them.
+	auto buffer = QByteArray(kTouchChunkSize, Qt::Uninitialized);
+	while (size > 0 && !LoadStarted) {
+		const auto read = f.read(
+			buffer.data(),
+			std::min(size, int64(buffer.size())));
+		if (read <= 0) {
+			break;
+		}
+		size -= read;
+	}
+}
+
+} // namespace
+
+void RememberUsedLanguages(const std::vector<QString> &languages) {
+	const auto workingDir = WorkingDirPath();
+	if (workingDir.isEmpty()) {
+		return;
+	}
+	const auto regions = UsedRegions(workingDir, languages);
+	if (ReadProfile(workingDir) == regions) {
+		return;
+	}
+	auto f = QFile(ProfilePath(workingDir));
+	if (!f.open(QIODevice::WriteOnly)) {
+		return;
+	}
+	for (const auto &region : regions) {
+		f.write(region.path.toUtf8()
+			+ '\t'
+			+ QByteArray::number(region.size)
+			+ '\n');
+	}
+}
+
+void PrefetchUsedDictionaries() {
+	const auto workingDir = WorkingDirPath();
+	if (workingDir.isEmpty()
+		|| LoadStarted
+		|| PrefetchStarted.exchange(true)) {
+		return;
+	}
+	crl::async([=] {
+		for (const auto &region : ReadProfile(workingDir)) {
+			Prefetch(workingDir + '/' + region.path, region.size);
+		}
+	});
+}
+
+void DictionariesLoadStarted() {
+	LoadStarted = true;
+}
+
+} // namespace Spellchecker
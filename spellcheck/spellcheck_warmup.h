@@ -0,0 +1,29 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+namespace Spellchecker {
+
+// Files read by loading the dictionaries are remembered with their sizes
+// in "<working dir>/warmup", so the next launch can read them into
+// the page cache before the first check needs them. Hunspell parses
+// its files completely, so the data regions it touches are whole files.
+
+// Thread: Main.
+void RememberUsedLanguages(const std::vector<QString> &languages);
+
+// Thread: Any.
+// Returns immediately, the files are read in the background.
+// Only the first call before the dictionaries are loaded does it.
+void PrefetchUsedDictionaries();
+
+// Thread: Any.
+// Engines read the files themselves from now on, so the prefetch
+// stops reading them, only the hints to the kernel are left.
+void DictionariesLoadStarted();
+
+} // namespace Spellchecker
@@ -0,0 +1,206 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "spellcheck/spellcheck_workload.h"
+
+#include "spellcheck/spellcheck_utils.h"
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+
+namespace Spellchecker {
+namespace {
+
+constexpr auto kMaxEvents = 100000;
+constexpr auto kMaxWords = 1000000;
+constexpr auto kVersion = 2;
+
+struct Word {
+	int id = 0;
+	int length = 0;
+	QChar::Script script = QChar::Script_Unknown;
+	bool misspelled = false;
+};
+
+struct Event {
+	WorkloadCall call = WorkloadCall::CheckText;
+	int64 at = 0;
+	int64 duration = 0;
+	int length = 0;
+	int firstWord = 0;
+	int wordsCount = 0;
+};
+
+std::atomic<bool> Recording = false;
+std::mutex WorkloadMutex;
+int64 RecordingStart = 0;
+uint Seed = 0;
+std::vector<Event> Events;
+std::vector<Word> Words;
+// Hashes with a seed of this recording, they are never saved.
+std::unordered_map<uint64, int> WordIds;
+thread_local auto RecordersDepth = 0;
+
+int64 NowMicroseconds() {
+	using namespace std::chrono;
+	return duration_cast<microseconds>(
+		steady_clock::now().time_since_epoch()).count();
+}
+
+// In the order of WorkloadCall.
+const auto kCallNames = std::array<const char*, 4>{
+	"text",
+	"word",
+	"suggest",
+	"complete",
+};
+
+// Under the mutex.
+Word MakeWord(const QStringRef &word, bool misspelled) {
+	const auto hash = (uint64(qHash(word, Seed)) << 32)
+		| uint64(qHash(word, ~Seed));
+	auto result = Word();
+	result.id = WordIds.emplace(hash, int(WordIds.size())).first->second;
+	result.length = word.size();
+	result.script = WordScript(word);
+	result.misspelled = misspelled;
+	return result;
+}
+
+// The end of the call is taken by the caller before any work
+// of the recording, so only the call itself is in the duration.
+void Record(
+		WorkloadCall call,
+		int64 start,
+		int64 finish,
+		const QString &text,
+		const MisspelledWords &words,
+		const MisspelledWords &misspelled) {
+	std::lock_guard lock(WorkloadMutex);
+	if (!Recording
+		|| Events.size() >= kMaxEvents
+		|| Words.size() + words.size() > kMaxWords) {
+		return;
+	}
+	auto event = Event();
+	event.call = call;
+	event.at = start - RecordingStart;
+	event.duration = finish - start;
+	event.length = text.size();
+	event.firstWord = Words.size();
+	event.wordsCount = words.size();
+
+	// Both ranges are sorted by the position.
+	auto i = begin(misspelled);
+	for (const auto &[position, length] : words) {
+		while (i != end(misspelled) && i->first < position) {
+			++i;
+		}
+		const auto wrong = (i != end(misspelled) && i->first == position);
+		Words.push_back(
+			MakeWord(QStringRef(&text, position, length), wrong));
+	}
+	Events.push_back(event);
+}
+
+} // namespace
+
+void SetWorkloadRecording(bool enabled) {
+	std::lock_guard lock(WorkloadMutex);
+	if (enabled && !Recording) {
+		Events.clear();
+		Words.clear();
+		WordIds.clear();
+		Seed = uint(std::random_device()());
+		RecordingStart = NowMicroseconds();
+	}
+	Recording = enabled;
+}
+
+bool WorkloadRecording() {
+	return Recording;
+}
+
+QByteArray WorkloadToJson() {
+	std::lock_guard lock(WorkloadMutex);
+	auto events = QJsonArray();
+	for (const auto &event : Events) {
+		auto words = QJsonArray();
+		for (auto i = 0; i != event.wordsCount; i++) {
+			const auto &word = Words[event.firstWord + i];
+			words.append(QJsonArray{
+				word.id,
+				word.length,
+				int(word.script),
+				word.misspelled ? 1 : 0,
+			});
+		}
+		events.append(QJsonObject{
+			{ "call", kCallNames[int(event.call)] },
+			{ "at", double(event.at) },
+			{ "duration", double(event.duration) },
+			{ "length", event.length },
+			{ "words", words },
+		});
+	}
+	return QJsonDocument(QJsonObject{
+		{ "version", kVersion },
+		{ "events", events },
+	}).toJson(QJsonDocument::Compact);
+}
+
+WorkloadRecorder::WorkloadRecorder(WorkloadCall call, QStringView text)
+: _call(call)
+, _text(text.data())
+, _length(text.size()) {
+	// Checks of the shadow verification are not the load.
+	if (!RecordersDepth++
+		&& WorkloadRecording()
+		&& !ReferenceCheckRunning()) {
+		_start = NowMicroseconds();
+	}
+}
+
+WorkloadRecorder::~WorkloadRecorder() {
+	RecordersDepth--;
+}
+
+void WorkloadRecorder::finish(bool misspelled) {
+	if (_start < 0 || !_length) {
+		return;
+	}
+	const auto finished = NowMicroseconds();
+	const auto text = QString::fromRawData(_text, _length);
+	const auto word = MisspelledWords{ { 0, _length } };
+	Record(
+		_call,
+		_start,
+		finished,
+		text,
+		word,
+		misspelled ? word : MisspelledWords());
+}
+
+void WorkloadRecorder::finish(const MisspelledWords &misspelled) {
+	if (_start < 0 || !_length) {
+		return;
+	}
+	const auto finished = NowMicroseconds();
+	const auto text = QString::fromRawData(_text, _length);
+	const auto words = RangesFromText(text, [](const QString &) {
+		return false;
+	});
+	Record(_call, _start, finished, text, words, misspelled);
+}
+
+} // namespace Spellchecker
@@ -0,0 +1,62 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+#include "spellcheck/spellcheck_types.h"
+
+namespace Spellchecker {
+
+// The opt-in recording of the shape of the spellchecking load,
+// to reproduce it later with synthetic words and local dictionaries.
+// No text is kept: only the call types, timings, text lengths, and the
+// length, script and verdict of each word. Words get ids that are equal
+// for equal words within one recording, they are not hashes of words.
+
+enum class WorkloadCall {
+	CheckText,
+	CheckWord,
+	Suggest,
+	Complete,
+};
+
+// Thread: Any.
+// Enabling the recording drops the previous one.
+void SetWorkloadRecording(bool enabled);
+[[nodiscard]] bool WorkloadRecording();
+
+// Thread: Any.
+// {"version":2,"events":[{"call","at","duration","length","words":[[id,
+// length, script, misspelled], ...]}, ...]} with microseconds.
+// For completions a word is marked misspelled if nothing was found.
+[[nodiscard]] QByteArray WorkloadToJson();
+
+// Measures one call while the recording is enabled.
+// Only the outermost call on a thread is recorded, so words checked
+// inside a text check are not recorded as separate calls.
+class WorkloadRecorder final {
+public:
+	WorkloadRecorder(WorkloadCall call, QStringView text);
+	~WorkloadRecorder();
+
+	WorkloadRecorder(const WorkloadRecorder &) = delete;
+	WorkloadRecorder &operator=(const WorkloadRecorder &) = delete;
+
+	// The text is a single word.
+	void finish(bool misspelled);
+
+	// The text is split to words as in RangesFromText.
+	void finish(const MisspelledWords &misspelled);
+
+private:
+	const WorkloadCall _call;
+	const QChar *_text = nullptr;
+	int _length = 0;
+	int64 _start = -1;
+
+};
+
+} // namespace Spellchecker
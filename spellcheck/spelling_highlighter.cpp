@@ -7,6 +7,9 @@
 
 #include "spellcheck/spelling_highlighter.h"
 
+#include "spellcheck/spellcheck_autocorrect.h"
+#include "spellcheck/spellcheck_replacements.h"
+#include "spellcheck/spellcheck_trace.h"
 #include "spellcheck/spellcheck_value.h"
 #include "spellcheck/spellcheck_utils.h"
 #include "spellcheck/spelling_highlighter_helper.h"
@@ -15,6 +18,11 @@
 #include "ui/text/text_utilities.h"
 #include "ui/ui_utility.h"
 
+#include <QtGui/QTextBlockUserData>
+
+#include <condition_variable>
+#include <mutex>
+
 namespace Spellchecker {
 
 namespace {
@@ -119,6 +127,11 @@ inline QChar AddedSymbol(QStringView text, int position, int added) {
 	return text.at(position);
 }
 
+inline bool IsWordBoundary(QChar c) {
+	// The apostrophe is a part of a word, see IsWordSkippable().
+	return c.isSpace() || (c.isPunct() && c.unicode() != '\'');
+}
+
 inline MisspelledWord CorrectAccentValues(
 		const QString &oldText,
 		const QString &newText) {
@@ -146,13 +159,31 @@ inline MisspelledWord RangeFromCursorSelection(const QTextCursor &cursor) {
 	return MisspelledWord(start, cursor.selectionEnd() - start);
 }
 
+// Any change of the block text increases its revision,
+// so the cached ranges of the block are up to date
+// only while the revision is the same.
+class CheckedBlockData final : public QTextBlockUserData {
+public:
+	CheckedBlockData(int generation, int revision)
+	: generation(generation)
+	, revision(revision) {
+	}
+
+	const int generation;
+	const int revision;
+
+};
+
 } // namespace
 
 SpellingHighlighter::SpellingHighlighter(
 	not_null<Ui::InputField*> field,
 	rpl::producer<bool> enabled,
-	std::optional<CustomContextMenuItem> customContextMenuItem)
+	std::optional<CustomContextMenuItem> customContextMenuItem,
+	rpl::producer<std::vector<QString>> preferredLanguages)
 : QSyntaxHighlighter(field->rawTextEdit()->document())
+, _firstValidTaskId(std::make_shared<std::atomic<int>>(0))
+, _speculationId(std::make_shared<std::atomic<int>>(0))
 , _cursor(QTextCursor(document()->docHandle(), 0))
 , _coldSpellcheckingTimer([=] { checkChangedText(); })
 , _field(field)
@@ -172,7 +203,11 @@ SpellingHighlighter::SpellingHighlighter(
 	style::PaletteChanged(
 	) | rpl::start_with_next([=] {
 		updatePalette();
-		rehighlight();
+		if (isActive()) {
+			rehighlight();
+		} else {
+			_pendingRehighlight = true;
+		}
 	}, _lifetime);
 	updatePalette();
 
@@ -199,6 +234,13 @@ SpellingHighlighter::SpellingHighlighter(
 	}, _lifetime);
 
 	updateDocumentText();
+	_segmentedText.reset(documentText());
+
+	std::move(
+		preferredLanguages
+	) | rpl::start_with_next([=](std::vector<QString> languages) {
+		_preferredLanguages = std::move(languages);
+	}, _lifetime);
 
 	std::move(
 		enabled
@@ -208,10 +250,15 @@ SpellingHighlighter::SpellingHighlighter(
 
 	Spellchecker::SupportedScriptsChanged(
 	) | rpl::start_with_next([=] {
-		checkCurrentText();
+		checkCurrentTextWhenActive();
 	}, _lifetime);
 }
 
+SpellingHighlighter::~SpellingHighlighter() {
+	cancelCheckTasks();
+	cancelSpeculation();
+}
+
 void SpellingHighlighter::updatePalette() {
 	_misspelledFormat.setUnderlineColor(st::spellUnderline->c);
 }
@@ -222,6 +269,7 @@ void SpellingHighlighter::contentsChange(int pos, int removed, int added) {
 	}
 	if (document()->isEmpty()) {
 		updateDocumentText();
+		_segmentedText.reset(documentText());
 		_cachedRanges.clear();
 		return;
 	}
@@ -231,6 +279,10 @@ void SpellingHighlighter::contentsChange(int pos, int removed, int added) {
 			pos,
 			documentText().indexOf(QChar::ParagraphSeparator, pos));
 		updateDocumentText();
+		{
+			const auto span = TraceSpan("segmentation");
+			_segmentedText.update(documentText(), pos, removed, added);
+		}
 
 		const auto b = findBlock(pos);
 		const auto bLen = (document()->blockCount() > 1)
@@ -338,6 +390,7 @@ void SpellingHighlighter::contentsChange(int pos, int removed, int added) {
 			_coldSpellcheckingTimer.cancel();
 		}
 		_coldSpellcheckingTimer.callOnce(kColdSpellcheckingTimeout);
+		checkWordSpeculatively(pos + added);
 	} else {
 		// We forcefully increase the range of check
 		// when inserting a non-char. This can help when the user inserts
@@ -351,6 +404,42 @@ void SpellingHighlighter::contentsChange(int pos, int removed, int added) {
 
 		checkChangedText();
 	}
+
+	if (_autocorrectEnabled && IsWordBoundary(addedSymbol)) {
+		autocorrectWordBefore(pos);
+	}
+}
+
+void SpellingHighlighter::autocorrectWordBefore(int position) {
+	const auto word = getWordUnderPosition(position);
+	if (!word.second
+		|| EndOfWord(word) != position
+		|| isSkippableWord(word)) {
+		return;
+	}
+	const auto typo = partDocumentText(word.first, word.second);
+	const auto correction = FindAutocorrection(typo);
+	if (correction.isEmpty()) {
+		return;
+	}
+	// Words that are known to be correct are never replaced,
+	// and we don't wait for the engine to tell us that.
+	if (CachedVerdict(typo).value_or(false)
+		|| Platform::Spellchecker::IsWordInDictionary(typo)) {
+		return;
+	}
+
+	// The document can't be modified while it notifies about a change.
+	const auto weak = Ui::MakeWeak(this);
+	crl::on_main(weak, [=] {
+		if (partDocumentText(word.first, word.second) != typo) {
+			return;
+		}
+		auto cursor = QTextCursor(document());
+		cursor.setPosition(word.first);
+		cursor.setPosition(EndOfWord(word), QTextCursor::KeepAnchor);
+		cursor.insertText(correction);
+	});
 }
 
 void SpellingHighlighter::checkChangedText() {
@@ -366,39 +455,43 @@ void SpellingHighlighter::checkChangedText() {
 		_coldSpellcheckingTimer.cancel();
 	}
 
-	const auto wordUnderCursor = getWordUnderPosition(pos);
-	// If the length of the word is 0, there is no sense in checking it.
-	if (!wordUnderCursor.second) {
-		return;
-	}
-
-	const auto wordInCacheIt = [=] {
-		return ranges::find_if(_cachedRanges, [&](auto &&w) {
-			return w.first >= wordUnderCursor.first;
-		});
-	};
-
 	if (added > 0) {
-		const auto lastWordNewSelection = getWordUnderPosition(pos + added);
+		// The segmentation is kept up to date on each change,
+		// so we don't have to guess the words around the added text.
+		const auto words = _segmentedText.wordsBetween(pos, pos + added);
+		if (words.empty()) {
+			return;
+		}
 
 		// This is the same word.
-		if (wordUnderCursor == lastWordNewSelection) {
-			checkSingleWord(wordUnderCursor);
+		if (words.size() == 1) {
+			checkSingleWord(words.front());
 			return;
 		}
 
-		const auto beginNewSelection = wordUnderCursor.first;
-		const auto endNewSelection = EndOfWord(lastWordNewSelection);
+		const auto beginNewSelection = words.front().first;
+		const auto endNewSelection = EndOfWord(words.back());
 
 		invokeCheckText(
 			beginNewSelection,
 			endNewSelection - beginNewSelection,
 			[=](const MisspelledWords &r) {
-				ranges::insert(_cachedRanges, wordInCacheIt(), std::move(r));
+				ranges::insert(
+					_cachedRanges,
+					ranges::find_if(_cachedRanges, [&](auto &&w) {
+						return w.first >= beginNewSelection;
+					}),
+					std::move(r));
 		});
 		return;
 	}
 
+	const auto wordUnderCursor = getWordUnderPosition(pos);
+	// If the length of the word is 0, there is no sense in checking it.
+	if (!wordUnderCursor.second) {
+		return;
+	}
+
 	if (removed > 0) {
 		checkSingleWord(wordUnderCursor);
 	}
@@ -431,7 +524,40 @@ bool SpellingHighlighter::isSkippableWord(int position, int length) {
 	return IsWordSkippable(ref);
 }
 
+bool SpellingHighlighter::isActive() const {
+	return _textEdit->isVisible() || _textEdit->hasFocus();
+}
+
+void SpellingHighlighter::checkCurrentTextWhenActive() {
+	if (isActive()) {
+		_pendingCheck = false;
+		checkCurrentText();
+	} else {
+		// Fields of hidden windows and background chats
+		// are checked only once when they are shown again.
+		_pendingCheck = true;
+	}
+}
+
+void SpellingHighlighter::performPendingWork() {
+	if (!_enabled || !isActive()) {
+		return;
+	}
+	const auto check = _pendingCheck;
+	const auto rehighlightAll = _pendingRehighlight;
+	_pendingCheck = _pendingRehighlight = false;
+	if (check) {
+		// The check rehighlights the blocks anyway.
+		checkCurrentText();
+	} else if (rehighlightAll) {
+		rehighlight();
+	}
+}
+
 void SpellingHighlighter::checkCurrentText() {
+	// The whole text check supersedes results of all running checks.
+	cancelCheckTasks();
+	_checkedGeneration++;
 	if (document()->isEmpty()) {
 		_cachedRanges.clear();
 		return;
@@ -449,103 +575,201 @@ void SpellingHighlighter::invokeCheckText(
 		return;
 	}
 
-	const auto rangesOffset = textPosition;
-	const auto text = partDocumentText(textPosition, textLength);
+	auto task = CheckTask();
+	task.id = ++_lastTaskId;
+	task.generation = _checkedGeneration;
+	task.position = textPosition;
+	task.length = textLength;
+	task.text = documentText();
+	task.callback = std::move(callback);
+	_runningTasks.push_back(task.id);
+
 	const auto weak = Ui::MakeWeak(this);
-	_countOfCheckingTextAsync++;
 	crl::async([=,
-		text = std::move(text),
-		callback = std::move(callback)]() mutable {
-		MisspelledWords misspelledWordRanges;
-		Platform::Spellchecker::CheckSpellingText(
-			text,
-			&misspelledWordRanges);
-		if (rangesOffset) {
-			ranges::for_each(misspelledWordRanges, [&](auto &&range) {
-				range.first += rangesOffset;
+		firstValidTaskId = _firstValidTaskId,
+		languages = _preferredLanguages,
+		task = std::move(task)]() mutable {
+		// The check was superseded or the highlighter was destroyed
+		// before a thread took it.
+		if (task.id < firstValidTaskId->load()) {
+			return;
+		}
+		{
+			const auto hint = LanguageHint(std::move(languages));
+			const auto span = TraceSpan("invokeCheckText");
+			Platform::Spellchecker::CheckSpellingText(
+				TextPart(task.text, task.position, task.length),
+				&task.ranges);
+		}
+		if (task.position) {
+			ranges::for_each(task.ranges, [&](auto &&range) {
+				range.first += task.position;
 			});
 		}
-		crl::on_main(weak, [=,
-				text = std::move(text),
-				ranges = std::move(misspelledWordRanges),
-				callback = std::move(callback)]() mutable {
-			_countOfCheckingTextAsync--;
-			// Checking a large part of text can take an unknown amount of
-			// time. So we have to compare the text before and after async
-			// work.
-			// If the text has changed during async and we have more async,
-			// we don't perform further refreshing of cache and underlines.
-			// But if it was the last async, we should invoke a new one.
-			if (compareDocumentText(text, textPosition, textLength)) {
-				if (!_countOfCheckingTextAsync) {
-					checkCurrentText();
-				}
-				return;
-			}
-			auto filtered = filterSkippableWords(ranges);
-
-			// When we finish checking the text, the user can
-			// supplement the last word and there may be a situation where
-			// a part of the last word may not be underlined correctly.
-			// Example:
-			// 1. We insert a text with an incomplete last word.
-			// "Time in a bottl".
-			// 2. We don't wait for the check to be finished
-			// and end the last word with the letter "e".
-			// 3. invokeCheckText() will mark the last word "bottl" as
-			// misspelled.
-			// 4. checkSingleWord() will mark the "bottle" as correct and
-			// leave it as it is.
-			// 5. The first five letters of the "bottle" will be underlined
-			// and the sixth will not be underlined.
-			// We can fix it with a check of completeness of the last word.
-			if (filtered.size()) {
-				const auto lastWord = filtered.back();
-				if (const auto endOfText = textPosition + textLength;
-					EndOfWord(lastWord) == endOfText) {
-					const auto word = getWordUnderPosition(endOfText);
-					if (EndOfWord(word) != endOfText) {
-						filtered.pop_back();
-						checkSingleWord(word);
-					}
-				}
-			}
-
-			callback(std::move(filtered));
-			for (const auto &b : blocksFromRange(textPosition, textLength)) {
-				rehighlightBlock(b);
-			}
+		crl::on_main(weak, [=, task = std::move(task)]() mutable {
+			finishCheckTask(std::move(task));
 		});
 	});
 }
 
+void SpellingHighlighter::cancelCheckTasks() {
+	*_firstValidTaskId = _lastTaskId + 1;
+	_runningTasks.clear();
+}
+
+void SpellingHighlighter::finishCheckTask(CheckTask &&task) {
+	const auto it = ranges::find(_runningTasks, task.id);
+	if (it == end(_runningTasks)) {
+		return;
+	}
+	_runningTasks.erase(it);
+
+	// Checking a large part of text can take an unknown amount of
+	// time. So we have to compare the text before and after async
+	// work.
+	// If the text has changed during async and we have more async,
+	// we don't perform further refreshing of cache and underlines.
+	// But if it was the last async, we should invoke a new one.
+	if (compareDocumentText(task.text, task.position, task.length)) {
+		if (_runningTasks.empty()) {
+			checkCurrentText();
+		}
+		return;
+	}
+	auto mergeSpan = std::make_optional<TraceSpan>("merge");
+	auto filtered = filterSkippableWords(task.ranges);
+
+	// When we finish checking the text, the user can
+	// supplement the last word and there may be a situation where
+	// a part of the last word may not be underlined correctly.
+	// Example:
+	// 1. We insert a text with an incomplete last word.
+	// "Time in a bottl".
+	// 2. We don't wait for the check to be finished
+	// and end the last word with the letter "e".
+	// 3. invokeCheckText() will mark the last word "bottl" as
+	// misspelled.
+	// 4. checkSingleWord() will mark the "bottle" as correct and
+	// leave it as it is.
+	// 5. The first five letters of the "bottle" will be underlined
+	// and the sixth will not be underlined.
+	// We can fix it with a check of completeness of the last word.
+	if (filtered.size()) {
+		const auto lastWord = filtered.back();
+		if (const auto endOfText = task.position + task.length;
+			EndOfWord(lastWord) == endOfText) {
+			const auto word = getWordUnderPosition(endOfText);
+			if (EndOfWord(word) != endOfText) {
+				filtered.pop_back();
+				checkSingleWord(word);
+			}
+		}
+	}
+
+	task.callback(std::move(filtered));
+	markBlocksChecked(task.position, task.length, task.generation);
+	mergeSpan.reset();
+
+	const auto span = TraceSpan("rehighlight");
+	for (const auto &b : blocksFromRange(task.position, task.length)) {
+		rehighlightBlock(b);
+	}
+	resumeSpeculation();
+}
+
 void SpellingHighlighter::checkSingleWord(const MisspelledWord &singleWord) {
 	const auto weak = Ui::MakeWeak(this);
 	auto w = partDocumentText(singleWord.first, singleWord.second);
 	if (isSkippableWord(singleWord)) {
 		return;
 	}
+	// The word was usually checked speculatively while it was typed.
+	if (const auto verdict = CachedVerdict(w)) {
+		if (!*verdict) {
+			markWordMisspelled(singleWord);
+		}
+		return;
+	}
 	crl::async([=,
 		w = std::move(w),
+		languages = _preferredLanguages,
 		singleWord = std::move(singleWord)]() mutable {
-		if (Platform::Spellchecker::CheckSpelling(std::move(w))) {
+		const auto hint = LanguageHint(std::move(languages));
+		if (CheckCachedSpelling(w)) {
 			return;
 		}
 
 		crl::on_main(weak, [=,
 				singleWord = std::move(singleWord)]() mutable {
-			const auto posOfWord = singleWord.first;
-			ranges::insert(
-				_cachedRanges,
-				ranges::find_if(_cachedRanges, [&](auto &&w) {
-					return w.first >= posOfWord;
-				}),
-				singleWord);
-			rehighlightBlock(findBlock(posOfWord));
+			markWordMisspelled(singleWord);
+		});
+	});
+}
+
+void SpellingHighlighter::markWordMisspelled(const MisspelledWord &word) {
+	const auto posOfWord = word.first;
+	ranges::insert(
+		_cachedRanges,
+		ranges::find_if(_cachedRanges, [&](auto &&w) {
+			return w.first >= posOfWord;
+		}),
+		word);
+	rehighlightBlock(findBlock(posOfWord));
+}
+
+void SpellingHighlighter::checkWordSpeculatively(int position) {
+	const auto words = _segmentedText.wordsBetween(position, position);
+	if (words.empty() || isSkippableWord(words.back())) {
+		return;
+	}
+	const auto &[start, length] = words.back();
+	auto word = partDocumentText(start, length);
+	if (HasVerdict(word)) {
+		return;
+	} else if (_speculationInFlight || !_runningTasks.empty()) {
+		// Only the latest state of the word is worth checking,
+		// and the checks of the text go first.
+		_pendingSpeculation = std::move(word);
+		return;
+	}
+	speculate(std::move(word));
+}
+
+void SpellingHighlighter::resumeSpeculation() {
+	if (_speculationInFlight || !_runningTasks.empty()) {
+		return;
+	}
+	auto next = base::take(_pendingSpeculation);
+	if (!next.isEmpty() && !HasVerdict(next)) {
+		speculate(std::move(next));
+	}
+}
+
+void SpellingHighlighter::speculate(QString word) {
+	_speculationInFlight = true;
+
+	const auto weak = Ui::MakeWeak(this);
+	const auto id = ++*_speculationId;
+	crl::async([=,
+		speculationId = _speculationId,
+		languages = _preferredLanguages,
+		word = std::move(word)]() mutable {
+		if (id == speculationId->load()) {
+			const auto hint = LanguageHint(std::move(languages));
+			CheckSpellingSpeculatively(word);
+		}
+		crl::on_main(weak, [=] {
+			_speculationInFlight = false;
+			resumeSpeculation();
 		});
 	});
 }
 
+void SpellingHighlighter::cancelSpeculation() {
+	++*_speculationId;
+	_pendingSpeculation = QString();
+}
+
 bool SpellingHighlighter::hasUnspellcheckableTag(int begin, int length) {
 	// This method is called only in the context of separate words,
 	// so it is not supposed that the word can be in more than one block.
@@ -607,6 +831,14 @@ bool SpellingHighlighter::eventFilter(QObject *o, QEvent *e) {
 	if (!_enabled) {
 		return false;
 	}
+	if ((o == _textEdit)
+		&& (e->type() == QEvent::Show || e->type() == QEvent::FocusIn)) {
+		// Postpone until the widget is really visible.
+		const auto weak = Ui::MakeWeak(this);
+		crl::on_main(weak, [=] {
+			performPendingWork();
+		});
+	}
 	if (e->type() == QEvent::ContextMenu) {
 		const auto c = static_cast<QContextMenuEvent *>(e);
 		const auto menu = _textEdit->createStandardContextMenu();
@@ -648,12 +880,20 @@ bool SpellingHighlighter::enabled() {
 	return _enabled;
 }
 
+void SpellingHighlighter::setAutocorrectEnabled(bool enabled) {
+	_autocorrectEnabled = enabled;
+}
+
 void SpellingHighlighter::setEnabled(bool enabled) {
 	_enabled = enabled;
 	if (_enabled) {
 		updateDocumentText();
-		checkCurrentText();
+		_segmentedText.reset(documentText());
+		checkCurrentTextWhenActive();
 	} else {
+		cancelCheckTasks();
+		cancelSpeculation();
+		_checkedGeneration++;
 		_cachedRanges.clear();
 		rehighlight();
 	}
@@ -693,18 +933,139 @@ std::vector<QTextBlock> SpellingHighlighter::blocksFromRange(
 	return blocks;
 }
 
+void SpellingHighlighter::markBlocksChecked(
+		int pos,
+		int length,
+		int generation) {
+	for (auto b : blocksFromRange(pos, length)) {
+		// Only blocks that were checked entirely.
+		if (b.position() < pos
+			|| (b.position() + b.text().size() > pos + length)) {
+			continue;
+		}
+		b.setUserData(new CheckedBlockData(generation, b.revision()));
+	}
+}
+
+bool SpellingHighlighter::isBlockChecked(const QTextBlock &block) {
+	const auto data = dynamic_cast<CheckedBlockData*>(block.userData());
+	return data
+		&& (data->generation == _checkedGeneration)
+		&& (data->revision == block.revision());
+}
+
+bool SpellingHighlighter::hasVisibleMisspellings(int pos, int length) {
+	const auto entities = FindEntities(findBlock(pos).text());
+	const auto blockPosition = findBlock(pos).position();
+	return ranges::any_of(_cachedRanges, [&](const MisspelledWord &range) {
+		return IntersectsWordRanges(range, pos, length)
+			&& !IntersectsAnyOfEntities(
+				range.first - blockPosition,
+				range.second,
+				entities)
+			&& !isSkippableWord(range);
+	});
+}
+
+SpellingHighlighter::SendCheckResult SpellingHighlighter::checkBeforeSend(
+		crl::time timeout) {
+	const auto deadline = crl::now() + timeout;
+	auto result = SendCheckResult();
+	if (!_enabled || document()->isEmpty()) {
+		return result;
+	}
+
+	// Adjacent blocks that should be checked again are merged.
+	auto dirty = MisspelledWords();
+	for (auto b = document()->begin(); b.isValid(); b = b.next()) {
+		if (!isBlockChecked(b)) {
+			if (!dirty.empty() && EndOfWord(dirty.back()) == b.position()) {
+				dirty.back().second += b.length();
+			} else {
+				dirty.emplace_back(b.position(), b.length());
+			}
+		} else if (hasVisibleMisspellings(b.position(), b.length())) {
+			result.hasMisspellings = true;
+			return result;
+		}
+	}
+	if (dirty.empty()) {
+		return result;
+	}
+
+	struct State {
+		std::mutex mutex;
+		std::condition_variable finished;
+		std::vector<std::optional<MisspelledWords>> results;
+		int left = 0;
+	};
+	const auto state = std::make_shared<State>();
+	state->results.resize(dirty.size());
+	state->left = dirty.size();
+	// The tasks share the document text, each checks its own part.
+	const auto text = documentText();
+	for (auto i = 0; i < dirty.size(); i++) {
+		const auto from = dirty[i].first;
+		const auto length = dirty[i].second;
+		crl::async([=] {
+			auto misspelledWords = MisspelledWords();
+			Platform::Spellchecker::CheckSpellingText(
+				TextPart(text, from, length),
+				&misspelledWords);
+
+			std::lock_guard lock(state->mutex);
+			state->results[i] = std::move(misspelledWords);
+			if (!--state->left) {
+				state->finished.notify_one();
+			}
+		});
+	}
+
+	auto lock = std::unique_lock(state->mutex);
+	const auto wait = std::max(deadline - crl::now(), crl::time(0));
+	result.partial = !state->finished.wait_for(
+		lock,
+		std::chrono::milliseconds(wait),
+		[&] { return !state->left; });
+
+	for (auto i = 0; i < dirty.size(); i++) {
+		if (!state->results[i]) {
+			continue;
+		}
+		const auto offset = dirty[i].first;
+		const auto misspelled = ranges::any_of(
+			*state->results[i],
+			[&](const MisspelledWord &range) {
+				const auto position = offset + range.first;
+				const auto entities = FindEntities(findBlock(position).text());
+				return !isSkippableWord(position, range.second)
+					&& !IntersectsAnyOfEntities(
+						position - findBlock(position).position(),
+						range.second,
+						entities);
+			});
+		if (misspelled) {
+			result.hasMisspellings = true;
+			result.partial = false;
+			break;
+		}
+	}
+	return result;
+}
+
 int SpellingHighlighter::compareDocumentText(
 		const QString &text,
 		int textPos,
 		int textLen) {
-	if (_lastPlainText.size() < textPos + textLen) {
+	if (_lastPlainText.size() < textPos + textLen
+		|| text.size() < textPos + textLen) {
 		return -1;
 	}
 	const auto p = _lastPlainText.midRef(textPos, textLen);
 	if (p.isNull()) {
 		return -1;
 	}
-	return text.compare(p, Qt::CaseSensitive);
+	return text.midRef(textPos, textLen).compare(p, Qt::CaseSensitive);
 }
 
 void SpellingHighlighter::addSpellcheckerActions(
@@ -758,6 +1119,21 @@ void SpellingHighlighter::addSpellcheckerActions(
 
 	const auto word = cursorForPosition.selectedText();
 
+	const auto addSuggestions = [=](
+			const std::vector<QString> &suggestions,
+			const QTextCursor &newTextCursor) {
+		for (const auto &suggestion : suggestions) {
+			auto replaceWord = [=] {
+				RememberReplacement(word, suggestion);
+				const auto oldTextCursor = _textEdit->textCursor();
+				_textEdit->setTextCursor(newTextCursor);
+				_textEdit->textCursor().insertText(suggestion);
+				_textEdit->setTextCursor(oldTextCursor);
+			};
+			menu->addAction(suggestion, std::move(replaceWord));
+		}
+	};
+
 	const auto fillMenu = [=,
 		addToParentAndShow = std::move(addToParentAndShow),
 		menu = std::move(menu)](
@@ -808,15 +1184,7 @@ void SpellingHighlighter::addSpellcheckerActions(
 		}
 
 		addSeparator();
-		for (const auto &suggestion : suggestions) {
-			auto replaceWord = [=] {
-				const auto oldTextCursor = _textEdit->textCursor();
-				_textEdit->setTextCursor(newTextCursor);
-				_textEdit->textCursor().insertText(suggestion);
-				_textEdit->setTextCursor(oldTextCursor);
-			};
-			menu->addAction(suggestion, std::move(replaceWord));
-		}
+		addSuggestions(suggestions, newTextCursor);
 	};
 
 	const auto weak = Ui::MakeWeak(this);
@@ -824,21 +1192,37 @@ void SpellingHighlighter::addSpellcheckerActions(
 		newTextCursor = std::move(cursorForPosition),
 		fillMenu = std::move(fillMenu),
 		word = std::move(word)]() mutable {
+		using Platform::Spellchecker::kMaxSuggestions;
 
 		const auto isCorrect = Platform::Spellchecker::CheckSpelling(word);
 		std::vector<QString> suggestions;
 		if (!isCorrect) {
-			Platform::Spellchecker::FillSuggestionList(word, &suggestions);
+			// Corrections the user picked before go first, the engine
+			// is not asked at all if they are enough. Its guesses are
+			// gathered before the menu is shown, so the menu doesn't
+			// change under the cursor.
+			suggestions = FindReplacements(word);
+			if (suggestions.size() < kMaxSuggestions) {
+				auto guesses = std::vector<QString>();
+				Platform::Spellchecker::FillSuggestionList(word, &guesses);
+				for (auto &guess : guesses) {
+					if (!ranges::contains(suggestions, guess)) {
+						suggestions.push_back(std::move(guess));
+					}
+				}
+			}
+			if (suggestions.size() > kMaxSuggestions) {
+				suggestions.resize(kMaxSuggestions);
+			}
 		}
 
 		crl::on_main(weak, [=,
-				newTextCursor = std::move(newTextCursor),
 				suggestions = std::move(suggestions),
 				fillMenu = std::move(fillMenu)]() mutable {
 			fillMenu(
 				isCorrect,
 				std::move(suggestions),
-				std::move(newTextCursor));
+				newTextCursor);
 		});
 	});
 }
@@ -10,6 +10,7 @@
 #include "base/timer.h"
 #include "spellcheck/platform/platform_spellcheck.h"
 #include "spellcheck/spellcheck_types.h"
+#include "spellcheck/spellcheck_utils.h"
 #include "ui/widgets/input_fields.h"
 
 #include <QtGui/QSyntaxHighlighter>
@@ -18,6 +19,7 @@
 #include <QtWidgets/QTextEdit>
 
 #include <rpl/event_stream.h>
+#include <rpl/never.h>
 
 namespace Ui {
 struct ExtendedContextMenu;
@@ -33,16 +35,33 @@ public:
 		Fn<void()> callback;
 	};
 
+	struct SendCheckResult {
+		bool hasMisspellings = false;
+		// Some parts of the text were not checked before the deadline.
+		bool partial = false;
+	};
+
 	SpellingHighlighter(
 		not_null<Ui::InputField*> field,
 		rpl::producer<bool> enabled,
 		std::optional<CustomContextMenuItem> customContextMenuItem
-			= std::nullopt);
+			= std::nullopt,
+		rpl::producer<std::vector<QString>> preferredLanguages
+			= rpl::never<std::vector<QString>>());
+	~SpellingHighlighter();
 
 	void contentsChange(int pos, int removed, int added);
 	void checkCurrentText();
 	bool enabled();
 
+	// Replaces common typos when a word is finished.
+	void setAutocorrectEnabled(bool enabled);
+
+	// Blocks the main thread for no longer than the timeout.
+	// Underlined blocks that were not changed since their check
+	// are taken from the cache, other blocks are checked in parallel.
+	[[nodiscard]] SendCheckResult checkBeforeSend(crl::time timeout);
+
 	auto contextMenuCreated() {
 		return _contextMenuCreated.events();
 	}
@@ -64,15 +83,53 @@ protected:
 private:
 	void updatePalette();
 	void setEnabled(bool enabled);
+
+	// Hidden fields defer the work until they are shown or focused.
+	[[nodiscard]] bool isActive() const;
+	void checkCurrentTextWhenActive();
+	void performPendingWork();
 	void checkText(const QString &text);
 
+	// The check goes through the stages: the spellchecking in a thread,
+	// then validation, merge and rehighlight on the main thread.
+	// The task is moved from stage to stage with all its state.
+	// Stages are callbacks, not coroutines: the C++ standard is chosen
+	// by init_target() of the build helpers, and the builds with Qt
+	// older than 5.10 (see spellcheck_types.h) use compilers without
+	// coroutine support.
+	struct CheckTask {
+		int id = 0;
+		int generation = 0;
+		int position = 0;
+		int length = 0;
+		// The whole document, only the part at the position is checked.
+		QString text;
+		MisspelledWords ranges;
+		Fn<void(const MisspelledWords &ranges)> callback;
+	};
+
 	void invokeCheckText(
 		int textPosition,
 		int textLength,
 		Fn<void(const MisspelledWords &ranges)> callback);
+	void finishCheckTask(CheckTask &&task);
+	// Results of the running checks are dropped,
+	// the checks that were not taken by a thread yet are skipped.
+	void cancelCheckTasks();
 
 	void checkChangedText();
 	void checkSingleWord(const MisspelledWord &singleWord);
+	void markWordMisspelled(const MisspelledWord &word);
+
+	// The word that is being typed is checked in the background
+	// to have its verdict cached by the time it is finished.
+	// Only one word is checked at a time, the newer one replaces
+	// the word that waits for its turn.
+	void checkWordSpeculatively(int position);
+	void speculate(QString word);
+	void resumeSpeculation();
+	void cancelSpeculation();
+	void autocorrectWordBefore(int position);
 	MisspelledWords filterSkippableWords(MisspelledWords &ranges);
 	bool isSkippableWord(const MisspelledWord &range);
 	bool isSkippableWord(int position, int length);
@@ -83,26 +140,46 @@ private:
 	QString documentText();
 	void updateDocumentText();
 	QString partDocumentText(int pos, int length);
+	// Compares the same part of an older document text and the current one.
 	int compareDocumentText(const QString &text, int textPos, int textLen);
 	QString _lastPlainText;
 
 	std::vector<QTextBlock> blocksFromRange(int pos, int length);
+	void markBlocksChecked(int pos, int length, int generation);
+	bool isBlockChecked(const QTextBlock &block);
+	bool hasVisibleMisspellings(int pos, int length);
 
 	int size();
 	QTextBlock findBlock(int pos);
 
-	int _countOfCheckingTextAsync = 0;
+	// Tasks with smaller ids are cancelled, shared with the threads.
+	const std::shared_ptr<std::atomic<int>> _firstValidTaskId;
+	int _lastTaskId = 0;
+	std::vector<int> _runningTasks;
+	// Only the speculative check with the latest id is performed,
+	// and only while no checks of the text are running.
+	const std::shared_ptr<std::atomic<int>> _speculationId;
+	QString _pendingSpeculation;
+	bool _speculationInFlight = false;
+	// Invalidates the checked state of all blocks.
+	int _checkedGeneration = 0;
 
 	QTextCharFormat _misspelledFormat;
 	QTextCursor _cursor;
 
 	MisspelledWords _cachedRanges;
+	SegmentedText _segmentedText;
 	EntitiesInText _cachedSkippableEntities;
 
 	int _addedSymbols = 0;
 	int _removedSymbols = 0;
 	int _lastPosition = 0;
 	bool _enabled = true;
+	bool _autocorrectEnabled = false;
+	// Engines of these languages are probed first for this field.
+	std::vector<QString> _preferredLanguages;
+	bool _pendingCheck = false;
+	bool _pendingRehighlight = false;
 
 	base::Timer _coldSpellcheckingTimer;
 
@@ -0,0 +1,178 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "spellcheck/spellcheck_dictionary_log.h"
+#include "spellcheck/tests/spellcheck_tests.h"
+
+namespace {
+
+using namespace Spellchecker;
+using Tests::Words;
+
+[[nodiscard]] DictionaryLog Restored(const QByteArray &data) {
+	const auto result = DictionaryLog::FromSerialized(data);
+	SPELLCHECK_CHECK(result.has_value());
+	return result ? *result : DictionaryLog();
+}
+
+// Device ids are random 64-bit numbers, sequences and word lengths
+// grow past one byte, so all of the varints take several bytes.
+void TestRoundTrip() {
+	auto log = DictionaryLog();
+	const auto longWord = QString(300, QChar('w'));
+	log.add(longWord);
+	for (auto i = 0; i != 200; i++) {
+		log.add("word" + QString::number(i));
+	}
+	log.remove(QString("word7"));
+
+	const auto restored = Restored(log.delta(0));
+	SPELLCHECK_CHECK(restored.device() == log.device());
+	SPELLCHECK_CHECK(restored.lastSequence() == log.lastSequence());
+	SPELLCHECK_CHECK(restored.lastSequence() == 202);
+	SPELLCHECK_CHECK(restored.words() == log.words());
+	SPELLCHECK_CHECK(restored.words().size() == 200);
+	SPELLCHECK_CHECK(ranges::contains(restored.words(), longWord));
+	SPELLCHECK_CHECK(!ranges::contains(restored.words(), QString("word7")));
+	SPELLCHECK_CHECK(restored.redundantRecords() == 0);
+}
+
+// A saved log gets new records appended as they are.
+void TestAppended() {
+	auto log = DictionaryLog();
+	log.add(QString("first"));
+	log.add(QString("second"));
+	auto data = log.delta(0);
+
+	const auto since = log.lastSequence();
+	log.remove(QString("first"));
+	log.add(QString("third"));
+	data += log.records(since);
+
+	const auto restored = Restored(data);
+	SPELLCHECK_CHECK(restored.words() == Words({ "second", "third" }));
+	SPELLCHECK_CHECK(restored.lastSequence() == 4);
+	SPELLCHECK_CHECK(restored.redundantRecords() == 1);
+
+	// Only the changes after the sequence are in the delta.
+	auto peer = DictionaryLog();
+	auto peerSequence = uint64(0);
+	const auto changes = peer.merge(log.delta(3), &peerSequence);
+	SPELLCHECK_CHECK(changes.has_value());
+	SPELLCHECK_CHECK(peer.words() == Words({ "third" }));
+	SPELLCHECK_CHECK(peerSequence == 4);
+}
+
+void TestMalformed() {
+	auto log = DictionaryLog();
+	log.add(QString("word"));
+	const auto data = log.delta(0);
+
+	SPELLCHECK_CHECK(!DictionaryLog::FromSerialized(QByteArray()));
+	SPELLCHECK_CHECK(!DictionaryLog::FromSerialized("XXXX" + data.mid(4)));
+
+	// A record is cut in the middle.
+	SPELLCHECK_CHECK(!DictionaryLog::FromSerialized(data.left(
+		data.size() - 1)));
+
+	// A varint that never ends.
+	SPELLCHECK_CHECK(!DictionaryLog::FromSerialized(
+		data + QByteArray(12, char(0x80))));
+
+	// Nothing is applied from malformed data.
+	auto peer = DictionaryLog();
+	peer.add(QString("mine"));
+	auto peerSequence = uint64(0);
+	SPELLCHECK_CHECK(!peer.merge(data.left(data.size() - 1), &peerSequence));
+	SPELLCHECK_CHECK(peer.words() == Words({ "mine" }));
+	SPELLCHECK_CHECK(peer.lastSequence() == 1);
+}
+
+void TestMerge() {
+	auto a = DictionaryLog();
+	auto b = DictionaryLog();
+	auto aSeen = uint64(0);
+	auto bSeen = uint64(0);
+	const auto sync = [&] {
+		const auto aDelta = a.delta(bSeen);
+		const auto bDelta = b.delta(aSeen);
+		SPELLCHECK_CHECK(a.merge(bDelta, &aSeen).has_value());
+		SPELLCHECK_CHECK(b.merge(aDelta, &bSeen).has_value());
+	};
+
+	a.add(QString("shared"));
+	a.add(QString("gone"));
+	auto sequence = uint64(0);
+	const auto changes = b.merge(a.delta(0), &sequence);
+	SPELLCHECK_CHECK(changes.has_value());
+	SPELLCHECK_CHECK(changes->added == Words({ "shared", "gone" }));
+	SPELLCHECK_CHECK(changes->removed.empty());
+	SPELLCHECK_CHECK(sequence == a.lastSequence());
+
+	// The same records are applied only once.
+	const auto lastSequence = b.lastSequence();
+	const auto again = b.merge(a.delta(0), &sequence);
+	SPELLCHECK_CHECK(again.has_value());
+	SPELLCHECK_CHECK(again->added.empty() && again->removed.empty());
+	SPELLCHECK_CHECK(b.lastSequence() == lastSequence);
+
+	// A later change wins over an earlier one from another device.
+	b.remove(QString("gone"));
+	aSeen = 0;
+	bSeen = sequence;
+	sync();
+	SPELLCHECK_CHECK(a.words() == Words({ "shared" }));
+	SPELLCHECK_CHECK(b.words() == Words({ "shared" }));
+
+	// Concurrent changes with equal clocks converge by the device id.
+	a.add(QString("both"));
+	b.remove(QString("both"));
+	a.remove(QString("shared"));
+	b.add(QString("shared"));
+	sync();
+	SPELLCHECK_CHECK(a.words() == b.words());
+
+	// Merging never moves the clock back, so a change made after
+	// a sync wins on every device.
+	a.add(QString("after"));
+	sync();
+	SPELLCHECK_CHECK(ranges::contains(b.words(), QString("after")));
+	b.remove(QString("after"));
+	sync();
+	SPELLCHECK_CHECK(!ranges::contains(a.words(), QString("after")));
+	SPELLCHECK_CHECK(a.words() == b.words());
+}
+
+// Words that are not accepted are not recorded at all.
+void TestRejected() {
+	auto a = DictionaryLog();
+	a.add(QString("good"));
+	a.add(QString("bad"));
+
+	auto b = DictionaryLog();
+	auto sequence = uint64(0);
+	const auto changes = b.merge(a.delta(0), &sequence, [](
+			const QString &word) {
+		return word != QString("bad");
+	});
+	SPELLCHECK_CHECK(changes.has_value());
+	SPELLCHECK_CHECK(changes->added == Words({ "good" }));
+	SPELLCHECK_CHECK(b.words() == Words({ "good" }));
+	SPELLCHECK_CHECK(b.lastSequence() == 1);
+	SPELLCHECK_CHECK(sequence == a.lastSequence());
+	SPELLCHECK_CHECK(Restored(b.delta(0)).words() == Words({ "good" }));
+}
+
+} // namespace
+
+int main() {
+	TestRoundTrip();
+	TestAppended();
+	TestMalformed();
+	TestMerge();
+	TestRejected();
+	return Spellchecker::Tests::Result();
+}
@@ -0,0 +1,123 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "spellcheck/spellcheck_distance.h"
+#include "spellcheck/tests/spellcheck_tests.h"
+
+#include <algorithm>
+#include <random>
+
+namespace {
+
+using namespace Spellchecker;
+
+void TestKnownDistances() {
+	const auto levenshtein = [](const char *a, const char *b) {
+		return LevenshteinDistance(QString(a), QString(b));
+	};
+	const auto damerau = [](const char *a, const char *b) {
+		return DamerauDistance(QString(a), QString(b));
+	};
+	SPELLCHECK_CHECK(levenshtein("", "") == 0);
+	SPELLCHECK_CHECK(levenshtein("abc", "") == 3);
+	SPELLCHECK_CHECK(levenshtein("kitten", "sitting") == 3);
+	SPELLCHECK_CHECK(levenshtein("flaw", "lawn") == 2);
+
+	// A transposition is one edit only for Damerau.
+	SPELLCHECK_CHECK(levenshtein("teh", "the") == 2);
+	SPELLCHECK_CHECK(damerau("teh", "the") == 1);
+
+	// The optimal string alignment can't edit a transposed pair again.
+	SPELLCHECK_CHECK(damerau("ca", "abc") == 3);
+
+	// Code units outside of ASCII.
+	SPELLCHECK_CHECK(DamerauDistance(
+		QString::fromUtf8("привет"),
+		QString::fromUtf8("пирвет")) == 1);
+}
+
+// The plain optimal string alignment distance, as a reference.
+int ReferenceDistance(const QString &a, const QString &b, bool damerau) {
+	auto d = std::vector<std::vector<int>>(
+		a.size() + 1,
+		std::vector<int>(b.size() + 1));
+	for (auto i = 0; i <= a.size(); i++) {
+		for (auto j = 0; j <= b.size(); j++) {
+			if (!i || !j) {
+				d[i][j] = i + j;
+				continue;
+			}
+			const auto cost = (a.at(i - 1) == b.at(j - 1)) ? 0 : 1;
+			d[i][j] = std::min({
+				d[i - 1][j] + 1,
+				d[i][j - 1] + 1,
+				d[i - 1][j - 1] + cost,
+			});
+			if (damerau
+				&& i > 1
+				&& j > 1
+				&& a.at(i - 1) == b.at(j - 2)
+				&& a.at(i - 2) == b.at(j - 1)) {
+				d[i][j] = std::min(d[i][j], d[i - 2][j - 2] + 1);
+			}
+		}
+	}
+	return d[a.size()][b.size()];
+}
+
+// The bit-parallel matcher must agree with the plain DP.
+void TestMatcherAgreesWithReference() {
+	auto generator = std::mt19937(20240601);
+	const auto alphabet = QString::fromUtf8("abcdeабв");
+	const auto randomWord = [&](int maxLength) {
+		auto result = QString();
+		const auto length = int(generator() % (maxLength + 1));
+		for (auto i = 0; i != length; i++) {
+			result.append(alphabet.at(int(generator() % alphabet.size())));
+		}
+		return result;
+	};
+	for (auto i = 0; i != 2000; i++) {
+		// Patterns longer than 64 use the plain DP in the matcher.
+		const auto pattern = randomWord((i % 10) ? 12 : 80);
+		const auto text = randomWord((i % 10) ? 12 : 80);
+		const auto matcher = DistanceMatcher(pattern);
+		SPELLCHECK_CHECK(matcher.levenshtein(text)
+			== ReferenceDistance(pattern, text, false));
+		SPELLCHECK_CHECK(matcher.damerau(text)
+			== ReferenceDistance(pattern, text, true));
+		SPELLCHECK_CHECK(DamerauDistance(pattern, text)
+			== DamerauDistance(text, pattern));
+	}
+}
+
+void TestMaxDistance() {
+	const auto matcher = DistanceMatcher(QString("spelling"));
+	const auto distances = matcher.damerau({
+		QString("spelling"),
+		QString("speling"),
+		QString("sepllign"),
+		QString("xxxxxxxx"),
+		QString("s"),
+	}, 2);
+
+	// Farther candidates get the maximum distance + 1.
+	SPELLCHECK_CHECK(distances.size() == 5);
+	SPELLCHECK_CHECK(distances[0] == 0);
+	SPELLCHECK_CHECK(distances[1] == 1);
+	SPELLCHECK_CHECK(distances[2] == 2);
+	SPELLCHECK_CHECK(distances[3] == 3);
+	SPELLCHECK_CHECK(distances[4] == 3);
+}
+
+} // namespace
+
+int main() {
+	TestKnownDistances();
+	TestMatcherAgreesWithReference();
+	TestMaxDistance();
+	return Spellchecker::Tests::Result();
+}
@@ -0,0 +1,100 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "spellcheck/spellcheck_kernels.h"
+#include "spellcheck/tests/spellcheck_tests.h"
+
+#include <array>
+#include <random>
+
+namespace {
+
+using namespace Spellchecker;
+
+constexpr auto kMaxLength = 100;
+
+// Characters next to the ASCII bound, including the ones that
+// differ from ASCII only in the high byte.
+const auto kNonAscii = std::array<ushort, 6>{
+	0x80, 0xFF, 0x100, 0x17F, 0x7F00, 0xFFFF,
+};
+
+void TestNames() {
+	for (const auto kernels : {
+		TextKernels::Scalar,
+		TextKernels::Sse42,
+		TextKernels::Avx2,
+		TextKernels::Neon,
+	}) {
+		const auto name = QString::fromLatin1(TextKernelsName(kernels));
+		SPELLCHECK_CHECK(TextKernelsFromName(name) == kernels);
+	}
+	SPELLCHECK_CHECK(!TextKernelsFromName(QString("unknown")));
+}
+
+// Each supported variant must give the results of the plain loops
+// for any length, alignment and position of non-ASCII characters.
+void TestKernels(TextKernels kernels) {
+	if (!SetTextKernels(kernels)) {
+		return;
+	}
+	SPELLCHECK_CHECK(ActiveTextKernels() == kernels);
+
+	auto generator = std::mt19937(20240601);
+	auto buffer = std::vector<QChar>(kMaxLength + 4);
+	auto out = std::vector<char>(kMaxLength + 4);
+	for (auto i = 0; i != 5000; i++) {
+		const auto shift = int(generator() % 4);
+		const auto size = int(generator() % (kMaxLength + 1));
+		const auto text = buffer.data() + shift;
+		for (auto j = 0; j != size; j++) {
+			text[j] = QChar(ushort(generator() % 0x80));
+		}
+		const auto nonAscii = int(generator() % 3);
+		for (auto j = 0; j != nonAscii && size; j++) {
+			text[generator() % size] = QChar(
+				kNonAscii[generator() % kNonAscii.size()]);
+		}
+
+		auto expected = 0;
+		while (expected != size && text[expected].unicode() < 0x80) {
+			expected++;
+		}
+		SPELLCHECK_CHECK(AsciiPrefixLength(text, size) == expected);
+		SPELLCHECK_CHECK(IsAscii(text, size) == (expected == size));
+
+		// The bytes after the output must stay untouched.
+		std::fill(begin(out), end(out), char(0x7F));
+		NarrowAscii(text, expected, out.data());
+		for (auto j = 0; j != expected; j++) {
+			SPELLCHECK_CHECK(out[j] == char(text[j].unicode()));
+		}
+		SPELLCHECK_CHECK(out[expected] == char(0x7F));
+	}
+}
+
+} // namespace
+
+int main() {
+	TestNames();
+
+	// Scalar is always supported.
+	SPELLCHECK_CHECK(SetTextKernels(TextKernels::Scalar));
+	for (const auto kernels : {
+		TextKernels::Scalar,
+		TextKernels::Sse42,
+		TextKernels::Avx2,
+		TextKernels::Neon,
+	}) {
+		fprintf(
+			stderr,
+			"%s: %s\n",
+			TextKernelsName(kernels),
+			SetTextKernels(kernels) ? "checked" : "not supported");
+		TestKernels(kernels);
+	}
+	return Spellchecker::Tests::Result();
+}
@@ -0,0 +1,124 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "spellcheck/spellcheck_trie.h"
+#include "spellcheck/spellcheck_utils.h"
+#include "spellcheck/tests/spellcheck_tests.h"
+
+namespace {
+
+using namespace Spellchecker;
+using Tests::Words;
+
+// Every word is reported, so the ranges are the segmentation.
+[[nodiscard]] MisspelledWords AllWords(const QString &text) {
+	return RangesFromText(text, [](const QString &) {
+		return false;
+	});
+}
+
+[[nodiscard]] bool HasRange(
+		const MisspelledWords &ranges,
+		const QString &text,
+		const QString &word) {
+	const auto position = text.indexOf(word);
+	return (position >= 0)
+		&& ranges::contains(ranges, MisspelledWord(position, word.size()));
+}
+
+using Tries = std::vector<std::shared_ptr<const WordTrie>>;
+
+[[nodiscard]] int LongestMatch(
+		const Tries &tries,
+		const QChar *data,
+		int length) {
+	auto result = 0;
+	for (const auto &trie : tries) {
+		result = std::max(result, trie->longestMatch(data, length));
+	}
+	return result;
+}
+
+// The ranges of the boundary finder are split into contiguous parts,
+// each is the longest word of any dictionary at its start, or a run
+// of characters up to the next known word that is not after a mark.
+void CheckSplit(
+		const Tries &tries,
+		const QString &text,
+		const MisspelledWords &unsplit,
+		const MisspelledWords &split) {
+	auto next = split.begin();
+	for (const auto &[from, length] : unsplit) {
+		const auto till = from + length;
+		for (auto position = from; position != till; ++next) {
+			SPELLCHECK_CHECK(next != split.end());
+			if (next == split.end()) {
+				return;
+			}
+			const auto [start, size] = *next;
+			SPELLCHECK_CHECK(start == position);
+			SPELLCHECK_CHECK(size > 0 && start + size <= till);
+			if (start != position || size <= 0 || start + size > till) {
+				return;
+			}
+			const auto data = text.constData();
+			const auto match = LongestMatch(tries, data + start, till - start);
+			if (match != size) {
+				SPELLCHECK_CHECK(!match);
+				for (auto i = start + 1; i != start + size; i++) {
+					SPELLCHECK_CHECK(data[i].isMark()
+						|| !LongestMatch(tries, data + i, till - i));
+				}
+			}
+			position += size;
+		}
+	}
+	SPELLCHECK_CHECK(next == split.end());
+}
+
+void TestSegmentation() {
+	// Between the known words there is an unknown run ending with a mark.
+	const auto text = QString::fromUtf8(
+		"สวัสดีไทย hello สวัสดีกขกัไทย ไทยสวัสดี");
+	const auto unsplit = AllWords(text);
+
+	// Two engines of the script, the longest word of both is taken.
+	auto trie = std::make_shared<const WordTrie>(Words({ "สวัส", "ไทย" }));
+	auto other = std::make_shared<const WordTrie>(Words({ "สวัสดี" }));
+	AddSegmentationWords(QChar::Script_Thai, trie);
+	AddSegmentationWords(QChar::Script_Thai, other);
+	const auto split = AllWords(text);
+	CheckSplit({ trie, other }, text, unsplit, split);
+
+	SPELLCHECK_CHECK(HasRange(split, text, QString::fromUtf8("สวัสดี")));
+	SPELLCHECK_CHECK(HasRange(split, text, QString::fromUtf8("ไทย")));
+	SPELLCHECK_CHECK(HasRange(split, text, QString::fromUtf8("กขกั")));
+	SPELLCHECK_CHECK(HasRange(split, text, QString("hello")));
+	SPELLCHECK_CHECK(!HasRange(split, text, QString::fromUtf8("สวัส")));
+	SPELLCHECK_CHECK(!HasRange(split, text, QString::fromUtf8("กข")));
+
+	// Only the segmented scripts are split.
+	auto latin = std::make_shared<const WordTrie>(Words({ "he", "llo" }));
+	AddSegmentationWords(QChar::Script_Latin, latin);
+	SPELLCHECK_CHECK(AllWords(text) == split);
+
+	// The tries are owned by their engines and are not used when destroyed.
+	other = nullptr;
+	const auto shorter = AllWords(text);
+	CheckSplit({ trie }, text, unsplit, shorter);
+	SPELLCHECK_CHECK(HasRange(shorter, text, QString::fromUtf8("สวัส")));
+	SPELLCHECK_CHECK(!HasRange(shorter, text, QString::fromUtf8("สวัสดี")));
+
+	trie = nullptr;
+	SPELLCHECK_CHECK(AllWords(text) == unsplit);
+}
+
+} // namespace
+
+int main() {
+	TestSegmentation();
+	return Spellchecker::Tests::Result();
+}
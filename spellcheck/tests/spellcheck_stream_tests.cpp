@@ -0,0 +1,139 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "spellcheck/spellcheck_stream.h"
+#include "spellcheck/tests/spellcheck_tests.h"
+
+#include <QtCore/QTextBoundaryFinder>
+
+#include <random>
+
+namespace {
+
+using namespace Spellchecker;
+
+struct Piece {
+	int64 offset = 0;
+	QString text;
+	bool checked = false;
+};
+
+// Feeds the text in chunks of the given sizes, the last one is repeated.
+[[nodiscard]] std::vector<Piece> Stream(
+		const QString &text,
+		std::vector<int> sizes) {
+	auto result = std::vector<Piece>();
+	auto checker = StreamChecker([&](
+			int64 offset,
+			QStringView piece,
+			const MisspelledWords &ranges,
+			bool checked) {
+		SPELLCHECK_CHECK(checked || ranges.empty());
+		result.push_back({
+			offset,
+			QString(piece.data(), piece.size()),
+			checked,
+		});
+	});
+	auto position = 0;
+	for (auto i = 0; position < text.size(); i++) {
+		const auto size = sizes[std::min(i, int(sizes.size()) - 1)];
+		checker.feed(text.mid(position, size));
+		position += size;
+	}
+	checker.finish();
+	return result;
+}
+
+// Pieces are contiguous and not empty, together they are the text.
+void CheckCovers(const std::vector<Piece> &pieces, const QString &text) {
+	auto joined = QString();
+	for (const auto &piece : pieces) {
+		SPELLCHECK_CHECK(!piece.text.isEmpty());
+		SPELLCHECK_CHECK(piece.offset == joined.size());
+		joined += piece.text;
+	}
+	SPELLCHECK_CHECK(joined == text);
+}
+
+// Words are never split between the chunks.
+void TestWhitespaces() {
+	auto generator = std::mt19937(20240601);
+	const auto words = std::vector<QString>{
+		QString("word"),
+		QString("another"),
+		QString::fromUtf8("слово"),
+		QString("a"),
+	};
+	auto text = QString();
+	for (auto i = 0; i != 3000; i++) {
+		text += words[generator() % words.size()];
+		text += (generator() % 8) ? QChar(' ') : QChar('\n');
+	}
+	text += "last";
+
+	for (const auto size : { 1, 3, 7, 100, 4096 }) {
+		const auto pieces = Stream(text, { size });
+		CheckCovers(pieces, text);
+		for (auto i = 0; i != int(pieces.size()); i++) {
+			const auto &piece = pieces[i];
+			SPELLCHECK_CHECK(piece.checked);
+			if (i + 1 != int(pieces.size())) {
+				const auto last = piece.text.at(piece.text.size() - 1);
+				SPELLCHECK_CHECK(last.isSpace());
+			}
+		}
+		SPELLCHECK_CHECK(pieces.back().text.endsWith(QString("last")));
+	}
+}
+
+// A long run without whitespaces is cut at its word boundaries.
+void TestWordBoundaries() {
+	auto text = QString("start ");
+	for (auto i = 0; i != 8000; i++) {
+		text += "word,";
+	}
+	const auto pieces = Stream(text, { 1000 });
+	CheckCovers(pieces, text);
+	SPELLCHECK_CHECK(pieces.size() > 2);
+
+	auto finder = QTextBoundaryFinder(QTextBoundaryFinder::Word, text);
+	for (const auto &piece : pieces) {
+		SPELLCHECK_CHECK(piece.checked);
+		SPELLCHECK_CHECK(piece.text.size() <= 16 * 1024 + 1000);
+		finder.setPosition(int(piece.offset) + piece.text.size());
+		SPELLCHECK_CHECK(finder.isAtBoundary());
+	}
+}
+
+// A run without word boundaries is not checked up to the next whitespace.
+void TestNoBoundaries() {
+	const auto run = QString(40000, QChar('a'));
+	const auto text = "start " + run + " after words";
+	const auto pieces = Stream(text, { 4096 });
+	CheckCovers(pieces, text);
+
+	auto unchecked = QString();
+	for (const auto &piece : pieces) {
+		if (!piece.checked) {
+			unchecked += piece.text;
+		}
+	}
+	SPELLCHECK_CHECK(unchecked == run);
+	SPELLCHECK_CHECK(pieces.front().checked);
+	SPELLCHECK_CHECK(pieces.front().text == QString("start "));
+	SPELLCHECK_CHECK(pieces.back().checked);
+	SPELLCHECK_CHECK(pieces.back().text.endsWith(QString("words")));
+}
+
+} // namespace
+
+int main() {
+	TestWhitespaces();
+	TestWordBoundaries();
+	TestNoBoundaries();
+	return Spellchecker::Tests::Result();
+}
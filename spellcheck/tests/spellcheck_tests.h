@@ -0,0 +1,52 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#pragma once
+
+#include <cstdio>
+
+namespace Spellchecker::Tests {
+
+// Tests are plain executables registered with add_test(),
+// each one returns Result() from main().
+
+inline int &Failures() {
+	static auto result = 0;
+	return result;
+}
+
+inline void Check(
+		bool condition,
+		const char *expression,
+		const char *file,
+		int line) {
+	if (!condition) {
+		fprintf(stderr, "%s:%d: failed: %s\n", file, line, expression);
+		Failures()++;
+	}
+}
+
+// Test data is written as UTF-8 literals.
+[[nodiscard]] inline std::vector<QString> Words(
+		std::vector<const char*> list) {
+	auto result = std::vector<QString>();
+	for (const auto word : list) {
+		result.push_back(QString::fromUtf8(word));
+	}
+	return result;
+}
+
+[[nodiscard]] inline int Result() {
+	if (Failures()) {
+		fprintf(stderr, "%d checks failed.\n", Failures());
+	}
+	return Failures() ? 1 : 0;
+}
+
+} // namespace Spellchecker::Tests
+
+#define SPELLCHECK_CHECK(condition) \
+	::Spellchecker::Tests::Check((condition), #condition, __FILE__, __LINE__)
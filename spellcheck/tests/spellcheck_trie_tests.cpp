@@ -0,0 +1,93 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "spellcheck/spellcheck_trie.h"
+#include "spellcheck/tests/spellcheck_tests.h"
+
+namespace {
+
+using namespace Spellchecker;
+using Tests::Words;
+
+[[nodiscard]] int LongestMatch(const WordTrie &trie, const QString &text) {
+	return trie.longestMatch(text.constData(), text.size());
+}
+
+void TestEmpty() {
+	const auto trie = WordTrie();
+	SPELLCHECK_CHECK(trie.empty());
+	SPELLCHECK_CHECK(!trie.contains(QString("a")));
+	SPELLCHECK_CHECK(trie.complete(QString(), 10).empty());
+	SPELLCHECK_CHECK(LongestMatch(trie, QString("a")) == 0);
+
+	// Only empty words.
+	SPELLCHECK_CHECK(WordTrie(Words({ "" })).empty());
+}
+
+void TestContains() {
+	// Duplicates and empty words are dropped.
+	const auto trie = WordTrie(Words({
+		"cart", "car", "ca", "", "care", "cat", "dog", "car",
+	}));
+	SPELLCHECK_CHECK(!trie.empty());
+	for (const auto word : { "ca", "car", "cart", "care", "cat", "dog" }) {
+		SPELLCHECK_CHECK(trie.contains(QString(word)));
+	}
+	for (const auto word : { "", "c", "do", "dogs", "cars", "x" }) {
+		SPELLCHECK_CHECK(!trie.contains(QString(word)));
+	}
+}
+
+void TestComplete() {
+	const auto trie = WordTrie(Words({
+		"cart", "car", "ca", "care", "cat", "dog",
+	}));
+
+	// Shorter words go first, words of the same length are sorted.
+	SPELLCHECK_CHECK(trie.complete(QString("ca"), 10)
+		== Words({ "ca", "car", "cat", "care", "cart" }));
+	SPELLCHECK_CHECK(trie.complete(QString("ca"), 2)
+		== Words({ "ca", "car" }));
+	SPELLCHECK_CHECK(trie.complete(QString("car"), 10)
+		== Words({ "car", "care", "cart" }));
+	SPELLCHECK_CHECK(trie.complete(QString("x"), 10).empty());
+	SPELLCHECK_CHECK(trie.complete(QString("ca"), 0).empty());
+}
+
+void TestLongestMatch() {
+	const auto trie = WordTrie(Words({ "car", "cart", "dog", "ab" }));
+	SPELLCHECK_CHECK(LongestMatch(trie, QString("cartoon")) == 4);
+	SPELLCHECK_CHECK(LongestMatch(trie, QString("carpet")) == 3);
+	SPELLCHECK_CHECK(LongestMatch(trie, QString("dog")) == 3);
+	SPELLCHECK_CHECK(LongestMatch(trie, QString("do")) == 0);
+	SPELLCHECK_CHECK(LongestMatch(trie, QString("xcar")) == 0);
+
+	// A word can't end before a combining mark.
+	const auto acute = QString::fromUtf8("\xCC\x81");
+	SPELLCHECK_CHECK(LongestMatch(trie, "ab" + acute + "c") == 0);
+	SPELLCHECK_CHECK(LongestMatch(trie, "car" + acute) == 0);
+	SPELLCHECK_CHECK(LongestMatch(trie, "cart" + acute) == 3);
+}
+
+void TestNonAscii() {
+	const auto trie = WordTrie(Words({ "สวัสดี", "สวัส", "ไทย" }));
+	SPELLCHECK_CHECK(trie.contains(QString::fromUtf8("สวัสดี")));
+	SPELLCHECK_CHECK(trie.complete(QString::fromUtf8("สวั"), 10)
+		== Words({ "สวัส", "สวัสดี" }));
+	SPELLCHECK_CHECK(LongestMatch(trie, QString::fromUtf8("สวัสดีไทย"))
+		== QString::fromUtf8("สวัสดี").size());
+}
+
+} // namespace
+
+int main() {
+	TestEmpty();
+	TestContains();
+	TestComplete();
+	TestLongestMatch();
+	TestNonAscii();
+	return Spellchecker::Tests::Result();
+}
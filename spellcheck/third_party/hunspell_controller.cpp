@@ -8,10 +8,21 @@
 #include "spellcheck/third_party/hunspell_controller.h"
 
 #include "hunspell/hunspell.hxx"
+#include "spellcheck/spellcheck_dictionary_log.h"
+#include "spellcheck/spellcheck_distance.h"
+#include "spellcheck/spellcheck_kernels.h"
+#include "spellcheck/spellcheck_trace.h"
+#include "spellcheck/spellcheck_trie.h"
 #include "spellcheck/spellcheck_value.h"
+#include "spellcheck/spellcheck_warmup.h"
+#include "spellcheck/spellcheck_workload.h"
 
+#include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <QDir>
 #include <QFileInfo>
@@ -24,7 +35,34 @@ using WordsMap = std::map<QChar::Script, std::vector<QString>>;
 
 // Maximum number of words in the custom spellcheck dictionary.
 constexpr auto kMaxSyncableDictionaryWords = 1300;
+constexpr auto kMaxDictionaryLogSize = 1024 * 1024;
 constexpr auto kTimeLimitSuggestion = crl::time(1000);
+constexpr auto kMaxSuggestionDistance = 3;
+// Newer suggestion requests are noticed not later than this.
+constexpr auto kSuggestionWaitStep = crl::time(50);
+
+// Calls that are slower than this are remembered to not repeat them.
+constexpr auto kSlowSpellTime = crl::time(10);
+constexpr auto kSlowSuggestTime = crl::time(300);
+constexpr auto kMaxSlowWords = 256;
+// Suggestions for a word are not asked after it was slow this many times,
+// until the block expires or the dictionaries change.
+constexpr auto kSlowSuggestsToBlock = 2;
+constexpr auto kSuggestBlockTime = crl::time(10 * 60 * 1000);
+constexpr auto kMaxLoggedSlowCalls = 32;
+
+// Languages that write compound words without spaces,
+// their long words are remembered by engines once accepted.
+const auto kCompoundLanguages = std::vector<QString>{
+	"de",
+	"nl",
+	"sv",
+	"da",
+	"nb",
+};
+constexpr auto kMinCompoundLength = 10;
+constexpr auto kMaxCompoundWords = 20000;
+constexpr auto kMaxQueuedCompounds = 256;
 
 #ifdef Q_OS_WIN
 const auto kLineBreak = QByteArrayLiteral("\r\n");
@@ -36,12 +74,252 @@ auto LocaleNameFromLangId(int langId) {
 	return ::Spellchecker::LocaleFromLangId(langId).name();
 }
 
+std::vector<QString> ReadDictionaryWords(
+		const QString &dicPath,
+		QTextCodec *codec) {
+	auto f = QFile(dicPath);
+	if (!f.open(QIODevice::ReadOnly)) {
+		return {};
+	}
+	auto result = std::vector<QString>();
+	// The first line is the approximate number of words.
+	result.reserve(std::max(f.readLine().trimmed().toInt(), 0));
+	while (!f.atEnd()) {
+		// "word/FLAGS\tmorphology", where everything except the word
+		// is optional.
+		const auto line = f.readLine();
+		const auto length = ranges::find_if(line, [](char c) {
+			return (c == '/')
+				|| (c == '\t')
+				|| (c == ' ')
+				|| (c == '\r')
+				|| (c == '\n');
+		}) - line.begin();
+		if (length > 0) {
+			result.push_back(codec->toUnicode(line.constData(), length));
+		}
+	}
+	return result;
+}
+
+std::atomic<int64> EngineCheckedWords = 0;
+std::atomic<int64> EngineCalls = 0;
+
+std::mutex SlowCallsMutex;
+std::vector<SlowCall> SlowCallsLog;
+
+// Two 32-bit hashes with different seeds make collisions improbable,
+// since a remembered verdict is returned for any word with the same hash.
+uint64 WordHash(const QString &word) {
+	return (uint64(qHash(word, 0)) << 32)
+		| uint64(uint32(qHash(word, 0x9E3779B9U)));
+}
+
+void LogSlowCall(SlowCall call) {
+	std::lock_guard lock(SlowCallsMutex);
+	const auto it = ranges::upper_bound(
+		SlowCallsLog,
+		call.duration,
+		ranges::greater(),
+		&SlowCall::duration);
+	if (it - begin(SlowCallsLog) >= kMaxLoggedSlowCalls) {
+		return;
+	}
+	SlowCallsLog.insert(it, std::move(call));
+	if (SlowCallsLog.size() > kMaxLoggedSlowCalls) {
+		SlowCallsLog.pop_back();
+	}
+}
+
+// Words that made the engine slow.
+// Verdicts of spell are remembered, suggestions are not asked again
+// for a while after repeated slow calls.
+class SlowWords final {
+public:
+	[[nodiscard]] std::optional<bool> verdict(uint64 hash) const;
+	[[nodiscard]] bool suggestBlocked(uint64 hash) const;
+
+	void rememberVerdict(uint64 hash, bool verdict);
+	void rememberSlowSuggest(uint64 hash);
+	void clearSlowSuggests();
+
+private:
+	struct SlowSuggest {
+		int calls = 0;
+		crl::time blockedTill = 0;
+	};
+
+	void evict();
+
+	mutable std::mutex _mutex;
+	// Lets the usual case of no slow words avoid the locking.
+	std::atomic<int> _count = 0;
+	std::unordered_map<uint64, bool> _verdicts;
+	std::unordered_map<uint64, SlowSuggest> _slowSuggests;
+	std::deque<uint64> _order;
+
+};
+
+std::optional<bool> SlowWords::verdict(uint64 hash) const {
+	if (!_count.load(std::memory_order_relaxed)) {
+		return std::nullopt;
+	}
+	std::lock_guard lock(_mutex);
+	const auto it = _verdicts.find(hash);
+	return (it != end(_verdicts))
+		? std::make_optional(it->second)
+		: std::nullopt;
+}
+
+bool SlowWords::suggestBlocked(uint64 hash) const {
+	if (!_count.load(std::memory_order_relaxed)) {
+		return false;
+	}
+	std::lock_guard lock(_mutex);
+	const auto it = _slowSuggests.find(hash);
+	return (it != end(_slowSuggests))
+		&& (it->second.blockedTill > crl::now());
+}
+
+void SlowWords::rememberVerdict(uint64 hash, bool verdict) {
+	std::lock_guard lock(_mutex);
+	if (_verdicts.emplace(hash, verdict).second) {
+		_order.push_back(hash);
+		evict();
+	}
+}
+
+void SlowWords::rememberSlowSuggest(uint64 hash) {
+	std::lock_guard lock(_mutex);
+	const auto [it, inserted] = _slowSuggests.emplace(hash, SlowSuggest());
+	if (++it->second.calls >= kSlowSuggestsToBlock) {
+		it->second.calls = 0;
+		it->second.blockedTill = crl::now() + kSuggestBlockTime;
+	}
+	if (inserted) {
+		_order.push_back(hash);
+		evict();
+	}
+}
+
+void SlowWords::clearSlowSuggests() {
+	std::lock_guard lock(_mutex);
+	if (_slowSuggests.empty()) {
+		return;
+	}
+	_slowSuggests.clear();
+	_order.erase(ranges::remove_if(_order, [&](uint64 hash) {
+		return _verdicts.find(hash) == end(_verdicts);
+	}), end(_order));
+	_count = int(_order.size());
+}
+
+void SlowWords::evict() {
+	while (_order.size() > kMaxSlowWords) {
+		_verdicts.erase(_order.front());
+		_slowSuggests.erase(_order.front());
+		_order.pop_front();
+	}
+	_count = int(_order.size());
+}
+
+// Long words accepted by Hunspell, as hashes of the words as written.
+// Compound rules make such words the slowest to check, and a verdict
+// of an engine doesn't change while it is loaded, so a remembered word
+// gets exactly the verdict Hunspell gave it. Words are remembered
+// in the background, not on the check path.
+class CompoundCache final {
+public:
+	CompoundCache();
+
+	[[nodiscard]] static bool IsCandidate(const QString &word);
+
+	[[nodiscard]] bool accepts(uint64 hash) const;
+
+	// The word should be accepted by Hunspell as it is written.
+	void enqueue(uint64 hash);
+	[[nodiscard]] bool hasQueued() const;
+	void learnQueued();
+
+private:
+	mutable std::shared_mutex _mutex;
+	std::unordered_set<uint64> _words;
+	std::atomic<bool> _empty = true;
+
+	std::mutex _queueMutex;
+	std::vector<uint64> _queue;
+	std::atomic<int> _queued = 0;
+
+};
+
+CompoundCache::CompoundCache() {
+	// Enqueueing doesn't allocate on the check path.
+	_queue.reserve(kMaxQueuedCompounds);
+}
+
+bool CompoundCache::IsCandidate(const QString &word) {
+	return (word.size() >= kMinCompoundLength);
+}
+
+bool CompoundCache::accepts(uint64 hash) const {
+	if (_empty) {
+		return false;
+	}
+	std::shared_lock lock(_mutex);
+	return _words.find(hash) != end(_words);
+}
+
+void CompoundCache::enqueue(uint64 hash) {
+	std::lock_guard lock(_queueMutex);
+	if (_queue.size() < kMaxQueuedCompounds) {
+		_queue.push_back(hash);
+		_queued = int(_queue.size());
+	}
+}
+
+bool CompoundCache::hasQueued() const {
+	return _queued.load(std::memory_order_relaxed) > 0;
+}
+
+void CompoundCache::learnQueued() {
+	auto learning = std::vector<uint64>();
+	{
+		std::lock_guard lock(_queueMutex);
+		if (_queue.empty()) {
+			return;
+		}
+		std::swap(_queue, learning);
+		_queue.reserve(kMaxQueuedCompounds);
+		_queued = 0;
+	}
+	std::unique_lock lock(_mutex);
+	if (_words.size() + learning.size() > kMaxCompoundWords) {
+		_words.clear();
+	}
+	_words.insert(begin(learning), end(learning));
+	_empty = false;
+}
+
+// Most encodings of dictionaries keep ASCII as it is,
+// so ASCII words are narrowed without the codec.
+bool IsAsciiCompatible(not_null<QTextCodec*> codec) {
+	auto ascii = QString();
+	for (auto c = 1; c != 0x80; c++) {
+		ascii.append(QChar(c));
+	}
+	return codec->fromUnicode(ascii) == ascii.toLatin1();
+}
+
 QString CustomDictionaryPath() {
 	return QStringLiteral("%1/%2")
 		.arg(::Spellchecker::WorkingDirPath())
 		.arg("custom");
 }
 
+QString CustomDictionaryLogPath() {
+	return CustomDictionaryPath() + ".log";
+}
+
 class HunspellEngine {
 public:
 	HunspellEngine(const QString &lang);
@@ -51,9 +329,16 @@ public:
 
 	bool spell(const QString &word) const;
 
+	// Long words accepted by spell() are remembered in the background.
+	[[nodiscard]] bool hasCompoundsToLearn() const;
+	void learnCompounds() const;
+
 	void suggest(
 		const QString &wrongWord,
 		std::vector<QString> *optionalSuggestions);
+	void clearSlowSuggests() const;
+
+	std::vector<QString> complete(const QString &prefix, int limit) const;
 
 	QString lang();
 	QChar::Script script();
@@ -62,10 +347,25 @@ public:
 	HunspellEngine &operator=(const HunspellEngine &) = delete;
 
 private:
+	bool spellDirectly(const QString &word) const;
+	// Returns nullptr until the words are read in the background.
+	[[nodiscard]] auto completions() const
+		-> std::shared_ptr<const ::Spellchecker::WordTrie>;
+
 	QString _lang;
 	QChar::Script _script;
 	std::unique_ptr<Hunspell> _hunspell;
 	QTextCodec *_codec;
+	bool _asciiCompatible = false;
+	QString _dicPath;
+	struct Completions {
+		std::mutex mutex;
+		std::shared_ptr<const ::Spellchecker::WordTrie> words;
+		bool requested = false;
+	};
+	const std::shared_ptr<Completions> _completions;
+	mutable SlowWords _slowWords;
+	std::unique_ptr<CompoundCache> _compounds;
 
 };
 
@@ -76,36 +376,67 @@ public:
 	~HunspellService();
 
 	void updateLanguages(std::vector<QString> langs);
+	void loadLanguages(std::vector<QString> langs);
 	std::vector<QString> activeLanguages();
 	[[nodiscard]] bool checkSpelling(const QString &wordToCheck);
 
 	void fillSuggestionList(
 		const QString &wrongWord,
 		std::vector<QString> *optionalSuggestions);
+	void fillCompletionList(
+		const QString &prefix,
+		std::vector<QString> *completions);
 
 	void addWord(const QString &word);
 	void removeWord(const QString &word);
 	void ignoreWord(const QString &word);
 	bool isWordInDictionary(const QString &word);
 
+	[[nodiscard]] QByteArray dictionaryDelta(uint64 sinceSequence) const;
+	bool applyDictionaryDelta(const QByteArray &delta, uint64 *peerSequence);
+
 private:
+	using EnginesOrder = std::vector<not_null<HunspellEngine*>>;
+
+	void learnCompoundsLater();
+	void clearSlowSuggests();
+	[[nodiscard]] const EnginesOrder &hintedEngines() const;
+
 	void writeToFile();
 	void readFile();
+	[[nodiscard]] QStringList readWordsFile();
+	[[nodiscard]] bool readLog();
+	void writeLog();
+	void appendToLog(uint64 sinceSequence);
+
+	[[nodiscard]] int addedWordsCount() const;
+	void addToDictionary(const QString &word);
+	void removeFromDictionary(const QString &word);
 
 	std::vector<QString> &addedWords(const QString &word);
 
-	std::shared_ptr<std::vector<std::unique_ptr<HunspellEngine>>> _engines;
+	// Engines are removed from the list only under the unique lock,
+	// suggestions keep their engines alive without the lock.
+	std::shared_ptr<std::vector<std::shared_ptr<HunspellEngine>>> _engines;
 	std::vector<QString> _activeLanguages;
 	// Use an empty Hunspell dictionary to fill it with our remembered words
 	// for getting suggests.
 	std::unique_ptr<Hunspell> _customDict;
 	WordsMap _ignoredWords;
 	WordsMap _addedWords;
+	// The custom words are changed on main and read from any thread,
+	// so the other threads read them under the shared lock.
+	mutable std::shared_mutex _customMutex;
+	// Changes of the added words for syncing them between devices.
+	::Spellchecker::DictionaryLog _log;
 
 	std::shared_ptr<std::atomic<int>> _epoch;
 	std::atomic<int> _suggestionsEpoch = 0;
 
 	std::shared_ptr<std::shared_mutex> _engineMutex;
+	// Changed under the unique lock with the engines.
+	std::shared_ptr<std::atomic<uint64>> _enginesGeneration;
+	std::shared_ptr<std::atomic<bool>> _compoundsLearning;
 
 };
 
@@ -113,7 +444,8 @@ HunspellEngine::HunspellEngine(const QString &lang)
 : _lang(lang)
 , _script(::Spellchecker::LocaleToScriptCode(lang))
 , _hunspell(nullptr)
-, _codec(nullptr) {
+, _codec(nullptr)
+, _completions(std::make_shared<Completions>()) {
 	const auto workingDir = ::Spellchecker::WorkingDirPath();
 	if (workingDir.isEmpty()) {
 		return;
@@ -139,6 +471,24 @@ HunspellEngine::HunspellEngine(const QString &lang)
 	_codec = QTextCodec::codecForName(_hunspell->get_dic_encoding());
 	if (!_codec) {
 		_hunspell.reset();
+		return;
+	}
+	_asciiCompatible = IsAsciiCompatible(_codec);
+
+	// Words of the dictionary are read in the background after
+	// the first completion, or right away for scripts that are split
+	// by them.
+	_dicPath = QString::fromUtf8(dicPath);
+	if (::Spellchecker::IsSegmentedScript(_script)) {
+		_completions->requested = true;
+		_completions->words = std::make_shared<::Spellchecker::WordTrie>(
+			ReadDictionaryWords(_dicPath, _codec));
+		::Spellchecker::AddSegmentationWords(_script, _completions->words);
+	}
+
+	const auto language = lang.left(lang.indexOf('_'));
+	if (ranges::contains(kCompoundLanguages, language)) {
+		_compounds = std::make_unique<CompoundCache>();
 	}
 }
 
@@ -147,15 +497,75 @@ bool HunspellEngine::isValid() const {
 }
 
 bool HunspellEngine::spell(const QString &word) const {
-	return _hunspell->spell(_codec->fromUnicode(word).toStdString());
+	if (::Spellchecker::ReferenceCheckRunning()) {
+		return spellDirectly(word);
+	}
+	const auto hash = WordHash(word);
+	if (const auto verdict = _slowWords.verdict(hash)) {
+		return *verdict;
+	}
+	if (_compounds && _compounds->accepts(hash)) {
+		return true;
+	}
+	const auto start = crl::now();
+	const auto result = spellDirectly(word);
+	if (const auto duration = crl::now() - start;
+		duration >= kSlowSpellTime) {
+		_slowWords.rememberVerdict(hash, result);
+		LogSlowCall({ _lang, hash, duration, false });
+	}
+	if (result && _compounds && CompoundCache::IsCandidate(word)) {
+		_compounds->enqueue(hash);
+	}
+	return result;
+}
+
+bool HunspellEngine::hasCompoundsToLearn() const {
+	return _compounds && _compounds->hasQueued();
+}
+
+void HunspellEngine::learnCompounds() const {
+	if (_compounds) {
+		_compounds->learnQueued();
+	}
+}
+
+bool HunspellEngine::spellDirectly(const QString &word) const {
+	const auto encoded = [&] {
+		const auto span = ::Spellchecker::TraceSpan("encode");
+		if (_asciiCompatible
+			&& !::Spellchecker::ReferenceCheckRunning()
+			&& ::Spellchecker::IsAscii(word.constData(), word.size())) {
+			auto result = std::string(word.size(), char(0));
+			::Spellchecker::NarrowAscii(
+				word.constData(),
+				word.size(),
+				result.data());
+			return result;
+		}
+		return _codec->fromUnicode(word).toStdString();
+	}();
+	const auto span = ::Spellchecker::TraceSpan("hunspell_spell");
+	return _hunspell->spell(encoded);
 }
 
 void HunspellEngine::suggest(
 	const QString &wrongWord,
 	std::vector<QString> *optionalSuggestions) {
+	const auto hash = WordHash(wrongWord);
+	if (_slowWords.suggestBlocked(hash)) {
+		return;
+	}
 	const auto stdWord = _codec->fromUnicode(wrongWord).toStdString();
 
-	for (const auto &guess : _hunspell->suggest(stdWord)) {
+	const auto start = crl::now();
+	const auto guesses = _hunspell->suggest(stdWord);
+	if (const auto duration = crl::now() - start;
+		duration >= kSlowSuggestTime) {
+		_slowWords.rememberSlowSuggest(hash);
+		LogSlowCall({ _lang, hash, duration, true });
+	}
+	for (const auto &guess : guesses) {
 		if (optionalSuggestions->size()	== kMaxSuggestions) {
 			return;
 		}
@@ -169,6 +579,37 @@ void HunspellEngine::suggest(
 	}
 }
 
+void HunspellEngine::clearSlowSuggests() const {
+	_slowWords.clearSlowSuggests();
+}
+
+std::vector<QString> HunspellEngine::complete(
+		const QString &prefix,
+		int limit) const {
+	const auto words = completions();
+	return words
+		? words->complete(prefix, limit)
+		: std::vector<QString>();
+}
+
+auto HunspellEngine::completions() const
+-> std::shared_ptr<const ::Spellchecker::WordTrie> {
+	std::lock_guard lock(_completions->mutex);
+	if (!_completions->requested && !_dicPath.isEmpty()) {
+		_completions->requested = true;
+		crl::async([
+				completions = _completions,
+				path = _dicPath,
+				codec = _codec] {
+			auto words = std::make_shared<::Spellchecker::WordTrie>(
+				ReadDictionaryWords(path, codec));
+			std::lock_guard lock(completions->mutex);
+			completions->words = std::move(words);
+		});
+	}
+	return _completions->words;
+}
+
 QString HunspellEngine::lang() {
 	return _lang;
 }
@@ -183,10 +624,12 @@ std::vector<QString> HunspellService::activeLanguages() {
 
 // Thread: Any.
 HunspellService::HunspellService()
-: _engines(std::make_shared<std::vector<std::unique_ptr<HunspellEngine>>>())
+: _engines(std::make_shared<std::vector<std::shared_ptr<HunspellEngine>>>())
 , _customDict(std::make_unique<Hunspell>("", ""))
 , _epoch(std::make_shared<std::atomic<int>>(0))
-, _engineMutex(std::make_shared<std::shared_mutex>()) {
+, _engineMutex(std::make_shared<std::shared_mutex>())
+, _enginesGeneration(std::make_shared<std::atomic<uint64>>(0))
+, _compoundsLearning(std::make_shared<std::atomic<bool>>(false)) {
 	readFile();
 }
 
@@ -211,10 +654,12 @@ void HunspellService::updateLanguages(std::vector<QString> langs) {
 	crl::async([=,
 		epoch = _epoch,
 		engineMutex = _engineMutex,
+		enginesGeneration = _enginesGeneration,
 		engines = _engines] {
-		using UniqueEngine = std::unique_ptr<HunspellEngine>;
+		const auto span = ::Spellchecker::TraceSpan("updateLanguages");
+		using SharedEngine = std::shared_ptr<HunspellEngine>;
 
-		const auto engineLangFilter = [&](const UniqueEngine &engine) {
+		const auto engineLangFilter = [&](const SharedEngine &engine) {
 			return engine ? ranges::contains(langs, engine->lang()) : false;
 		};
 
@@ -222,7 +667,7 @@ void HunspellService::updateLanguages(std::vector<QString> langs) {
 			return;
 		}
 
-		const auto engineLang = [](const UniqueEngine &engine) {
+		const auto engineLang = [](const SharedEngine &engine) {
 			return engine ? engine->lang() : QString();
 		};
 
@@ -236,14 +681,18 @@ void HunspellService::updateLanguages(std::vector<QString> langs) {
 			}) | ranges::to_vector;
 		}();
 
+		if (!missedLangs.empty()) {
+			::Spellchecker::DictionariesLoadStarted();
+		}
+
 		// Added new enabled engines.
 		auto localEngines = ranges::view::all(
 			missedLangs
-		) | ranges::views::transform([&](auto &lang) -> UniqueEngine {
+		) | ranges::views::transform([&](auto &lang) -> SharedEngine {
 			if (savedEpoch != epoch.get()->load()) {
 				return nullptr;
 			}
-			auto engine = std::make_unique<HunspellEngine>(lang);
+			auto engine = std::make_shared<HunspellEngine>(lang);
 			if (!engine->isValid()) {
 				return nullptr;
 			}
@@ -265,6 +714,7 @@ void HunspellService::updateLanguages(std::vector<QString> langs) {
 			) | ranges::views::transform([](auto &engine) {
 				return std::move(engine);
 			}) | ranges::to_vector;
+			++*enginesGeneration;
 		}
 
 		crl::on_main([=] {
@@ -277,80 +727,316 @@ void HunspellService::updateLanguages(std::vector<QString> langs) {
 			) | ranges::views::transform(&HunspellEngine::lang)
 			| ranges::to_vector;
 			::Spellchecker::UpdateSupportedScripts(_activeLanguages);
+			::Spellchecker::RememberUsedLanguages(_activeLanguages);
 		});
 
 	});
 }
 
+// Thread: Main.
+void HunspellService::loadLanguages(std::vector<QString> langs) {
+	Expects(_epoch.get()->load() == 0);
+
+	::Spellchecker::DictionariesLoadStarted();
+	auto engines = std::vector<std::shared_ptr<HunspellEngine>>();
+	for (const auto &lang : langs) {
+		auto engine = std::make_shared<HunspellEngine>(lang);
+		if (engine->isValid()) {
+			engines.push_back(std::move(engine));
+		}
+	}
+	{
+		std::unique_lock lock(*_engineMutex);
+		*_engines = std::move(engines);
+		++*_enginesGeneration;
+	}
+	_activeLanguages = ranges::view::all(
+		*_engines
+	) | ranges::views::transform(&HunspellEngine::lang)
+	| ranges::to_vector;
+	::Spellchecker::UpdateSupportedScripts(_activeLanguages);
+}
+
 // Thread: Any.
 bool HunspellService::checkSpelling(const QString &wordToCheck) {
+	const auto span = ::Spellchecker::TraceSpan("checkSpelling");
 	const auto wordScript = ::Spellchecker::WordScript(&wordToCheck);
-	if (ranges::contains(_ignoredWords[wordScript], wordToCheck)) {
-		return true;
-	}
-	if (ranges::contains(_addedWords[wordScript], wordToCheck)) {
-		return true;
+	const auto custom = [&](const WordsMap &words) {
+		const auto it = words.find(wordScript);
+		return (it != end(words))
+			&& ranges::contains(it->second, wordToCheck);
+	};
+	{
+		std::shared_lock lock(_customMutex);
+		if (custom(_ignoredWords) || custom(_addedWords)) {
+			return true;
+		}
 	}
 	std::shared_lock lock(*_engineMutex);
-	for (const auto &engine : *_engines) {
+	EngineCheckedWords++;
+	const auto spell = [&](not_null<HunspellEngine*> engine) {
 		if (wordScript != engine->script()) {
-			continue;
+			return false;
 		}
-		if (engine->spell(wordToCheck)) {
-			return true;
+		EngineCalls++;
+		if (!engine->spell(wordToCheck)) {
+			return false;
+		} else if (engine->hasCompoundsToLearn()) {
+			learnCompoundsLater();
 		}
+		return true;
+	};
+	if (::Spellchecker::LanguageHint::Empty()) {
+		for (const auto &engine : *_engines) {
+			if (spell(engine.get())) {
+				return true;
+			}
+		}
+		return false;
 	}
+	return ranges::any_of(hintedEngines(), spell);
+}
 
-	return false;
+// Thread: Any.
+// Under the shared lock of the engines.
+auto HunspellService::hintedEngines() const -> const EnginesOrder & {
+	struct Cached {
+		uint64 hint = 0;
+		uint64 engines = 0;
+		EnginesOrder order;
+	};
+	thread_local auto cached = Cached();
+	const auto hint = ::Spellchecker::LanguageHint::Generation();
+	const auto engines = _enginesGeneration->load();
+	if (cached.hint != hint || cached.engines != engines) {
+		cached.hint = hint;
+		cached.engines = engines;
+		cached.order = ranges::views::all(
+			*_engines
+		) | ranges::views::transform([](const auto &engine) {
+			return not_null<HunspellEngine*>(engine.get());
+		}) | ranges::to_vector;
+		ranges::stable_sort(cached.order, ranges::less(), [](
+				not_null<HunspellEngine*> engine) {
+			return ::Spellchecker::LanguageHint::Priority(engine->lang());
+		});
+	}
+	return cached.order;
+}
+
+// Thread: Main.
+// Blocks of slow suggestions are dropped when the dictionaries change.
+void HunspellService::clearSlowSuggests() {
+	std::shared_lock lock(*_engineMutex);
+	for (const auto &engine : *_engines) {
+		engine->clearSlowSuggests();
+	}
+}
+
+// Thread: Any.
+void HunspellService::learnCompoundsLater() {
+	if (_compoundsLearning->exchange(true)) {
+		return;
+	}
+	crl::async([
+			engines = _engines,
+			engineMutex = _engineMutex,
+			learning = _compoundsLearning] {
+		// Words queued from now on will schedule the next pass.
+		learning->store(false);
+
+		// Engines are removed only under the unique lock.
+		std::shared_lock lock(*engineMutex);
+		for (const auto &engine : *engines) {
+			engine->learnCompounds();
+		}
+	});
 }
 
 // Thread: Any.
 void HunspellService::fillSuggestionList(
 	const QString &wrongWord,
 	std::vector<QString> *optionalSuggestions) {
+	const auto span = ::Spellchecker::TraceSpan("fillSuggestionList");
 	const auto wordScript = ::Spellchecker::WordScript(&wrongWord);
 
-	const auto customGuesses = _customDict->suggest(wrongWord.toStdString());
-	*optionalSuggestions = ranges::view::all(
+	const auto customGuesses = [&] {
+		std::shared_lock lock(_customMutex);
+		return _customDict->suggest(wrongWord.toStdString());
+	}();
+	auto customSuggestions = ranges::view::all(
 		customGuesses
-	) | ranges::views::take(
-		kMaxSuggestions
 	) | ranges::views::transform([](auto &guess) {
 		return QString::fromStdString(guess);
 	}) | ranges::to_vector;
 
-	const auto startTime = crl::now();
+	// The empty dictionary has no affix rules to rank its guesses,
+	// so the closest of remembered words should go first.
+	const auto distances = ::Spellchecker::DistanceMatcher(
+		wrongWord
+	).damerau(customSuggestions, kMaxSuggestionDistance);
+	auto order = ranges::views::ints(
+		0,
+		int(customSuggestions.size())
+	) | ranges::to_vector;
+	ranges::stable_sort(order, ranges::less(), [&](int i) {
+		return distances[i];
+	});
+	*optionalSuggestions = ranges::view::all(
+		order
+	) | ranges::views::take(
+		kMaxSuggestions
+	) | ranges::views::transform([&](int i) {
+		return std::move(customSuggestions[i]);
+	}) | ranges::to_vector;
+
+	if (optionalSuggestions->size() == kMaxSuggestions) {
+		return;
+	}
+
+	const auto deadline = crl::now() + kTimeLimitSuggestion;
 
 	_suggestionsEpoch++;
 	const auto savedEpoch = _suggestionsEpoch.load();
 
-	{
+	// Engines go in the order of priority.
+	const auto engines = [&] {
 		std::shared_lock lock(*_engineMutex);
-		for (const auto &engine : *_engines) {
+		return ranges::view::all(
+			*_engines
+		) | ranges::views::filter([&](const auto &engine) {
+			return (engine->script() == wordScript);
+		}) | ranges::to_vector;
+	}();
+
+	// The first engine suggests in this thread and the others in the
+	// pool, so the user waits for the slowest one instead of their sum.
+	// This thread waits for them only until the deadline. Engines that
+	// didn't start before the request is finished are skipped.
+	struct State {
+		std::mutex mutex;
+		std::condition_variable finished;
+		std::vector<std::optional<std::vector<QString>>> guesses;
+		std::atomic<bool> cancelled = false;
+	};
+	const auto state = std::make_shared<State>();
+	state->guesses.resize(engines.size());
+	const auto suggest = [=](int i) {
+		auto guesses = std::vector<QString>();
+		if (!state->cancelled && crl::now() < deadline) {
+			engines[i]->suggest(wrongWord, &guesses);
+		}
+		std::lock_guard lock(state->mutex);
+		state->guesses[i] = std::move(guesses);
+		state->finished.notify_one();
+	};
+	for (auto i = 1; i < engines.size(); i++) {
+		crl::async([=] { suggest(i); });
+	}
+	if (!engines.empty()) {
+		if (_suggestionsEpoch.load() > savedEpoch) {
+			state->cancelled = true;
+		}
+		suggest(0);
+	}
+
+	// Guesses of an engine keep the ranking of Hunspell,
+	// guesses of the engines with higher priority go first.
+	const auto merge = [&](std::vector<QString> guesses) {
+		for (auto &guess : guesses) {
+			if (optionalSuggestions->size() == kMaxSuggestions) {
+				return;
+			} else if (!ranges::contains(*optionalSuggestions, guess)) {
+				optionalSuggestions->push_back(std::move(guess));
+			}
+		}
+	};
+
+	{
+		auto merged = 0;
+		std::unique_lock lock(state->mutex);
+		while (merged < engines.size()
+			&& optionalSuggestions->size() < kMaxSuggestions) {
 			if (_suggestionsEpoch.load() > savedEpoch) {
 				// There is a newer request to fill suggestion list,
 				// So we should drop the current one.
 				optionalSuggestions->clear();
 				break;
-			}
-			if (optionalSuggestions->size()	== kMaxSuggestions
-				|| ((crl::now() - startTime) > kTimeLimitSuggestion)) {
+			} else if (state->guesses[merged]) {
+				merge(*base::take(state->guesses[merged++]));
+			} else if (crl::now() >= deadline) {
 				break;
+			} else {
+				state->finished.wait_for(
+					lock,
+					std::chrono::milliseconds(kSuggestionWaitStep));
 			}
+		}
+	}
+	state->cancelled = true;
+	_suggestionsEpoch--;
+}
+
+// Thread: Any.
+void HunspellService::fillCompletionList(
+		const QString &prefix,
+		std::vector<QString> *completions) {
+	completions->clear();
+	const auto wordScript = ::Spellchecker::WordScript(&prefix);
+	const auto isCompletion = [&](const QString &word) {
+		return (word.size() > prefix.size()) && word.startsWith(prefix);
+	};
+
+	// Words of the user go first.
+	{
+		std::shared_lock lock(_customMutex);
+		if (const auto it = _addedWords.find(wordScript);
+			it != end(_addedWords)) {
+			*completions = ranges::view::all(
+				it->second
+			) | ranges::views::filter(
+				isCompletion
+			) | ranges::to_vector;
+		}
+	}
+	ranges::stable_sort(*completions, ranges::less(), &QString::size);
+	if (completions->size() > kMaxCompletions) {
+		completions->resize(kMaxCompletions);
+	}
+
+	auto guesses = std::vector<QString>();
+	{
+		std::shared_lock lock(*_engineMutex);
+		for (const auto &engine : *_engines) {
 			if (wordScript != engine->script()) {
 				continue;
 			}
-			engine->suggest(wrongWord, optionalSuggestions);
+			// The prefix itself can be a word, so ask for one more.
+			ranges::actions::push_back(
+				guesses,
+				engine->complete(prefix, kMaxCompletions + 1));
+		}
+	}
+	ranges::stable_sort(guesses, ranges::less(), &QString::size);
+	for (auto &guess : guesses) {
+		if (completions->size() == kMaxCompletions) {
+			break;
+		}
+		if (isCompletion(guess) && !ranges::contains(*completions, guess)) {
+			completions->push_back(std::move(guess));
 		}
 	}
-	_suggestionsEpoch--;
 }
 
 // Thread: Main.
 void HunspellService::ignoreWord(const QString &word) {
 	const auto wordScript = ::Spellchecker::WordScript(&word);
-	_customDict->add(word.toStdString());
-	_ignoredWords[wordScript].push_back(word);
+	{
+		std::unique_lock lock(_customMutex);
+		_customDict->add(word.toStdString());
+		_ignoredWords[wordScript].push_back(word);
+	}
+	clearSlowSuggests();
 }
 
 // Thread: Main.
@@ -359,26 +1045,137 @@ bool HunspellService::isWordInDictionary(const QString &word) {
 }
 
 // Thread: Main.
-void HunspellService::addWord(const QString &word) {
-	const auto count = ranges::accumulate(
+int HunspellService::addedWordsCount() const {
+	return ranges::accumulate(
 		ranges::view::values(_addedWords),
 		0,
 		ranges::plus(),
 		&std::vector<QString>::size);
-	if (count > kMaxSyncableDictionaryWords) {
-		return;
-	}
+}
+
+// Thread: Main.
+void HunspellService::addToDictionary(const QString &word) {
+	std::unique_lock lock(_customMutex);
 	_customDict->add(word.toStdString());
 	addedWords(word).push_back(word);
-	writeToFile();
 }
 
 // Thread: Main.
-void HunspellService::removeWord(const QString &word) {
+void HunspellService::removeFromDictionary(const QString &word) {
+	std::unique_lock lock(_customMutex);
 	_customDict->remove(word.toStdString());
 	auto &vector = addedWords(word);
 	vector.erase(ranges::remove(vector, word), end(vector));
+}
+
+// Thread: Main.
+void HunspellService::addWord(const QString &word) {
+	if (addedWordsCount() > kMaxSyncableDictionaryWords) {
+		return;
+	}
+	addToDictionary(word);
+	const auto since = _log.lastSequence();
+	_log.add(word);
+	appendToLog(since);
 	writeToFile();
+	clearSlowSuggests();
+}
+
+// Thread: Main.
+void HunspellService::removeWord(const QString &word) {
+	removeFromDictionary(word);
+	const auto since = _log.lastSequence();
+	_log.remove(word);
+	appendToLog(since);
+	writeToFile();
+	clearSlowSuggests();
+}
+
+// Thread: Main.
+QByteArray HunspellService::dictionaryDelta(uint64 sinceSequence) const {
+	return _log.delta(sinceSequence);
+}
+
+// Thread: Main.
+bool HunspellService::applyDictionaryDelta(
+		const QByteArray &delta,
+		uint64 *peerSequence) {
+	const auto since = _log.lastSequence();
+
+	// Words that are not added here are not written to the log.
+	auto count = addedWordsCount();
+	const auto changes = _log.merge(delta, peerSequence, [&](
+			const QString &word) {
+		if (count > kMaxSyncableDictionaryWords
+			|| ::Spellchecker::IsWordSkippable(&word, false)) {
+			return false;
+		}
+		++count;
+		return true;
+	});
+	if (!changes) {
+		return false;
+	} else if (_log.lastSequence() == since) {
+		return true;
+	}
+	// Only the changed words are touched.
+	for (const auto &word : changes->removed) {
+		removeFromDictionary(word);
+	}
+	for (const auto &word : changes->added) {
+		addToDictionary(word);
+	}
+	appendToLog(since);
+	writeToFile();
+	clearSlowSuggests();
+	::Spellchecker::ClearVerdictCache();
+	return true;
+}
+
+// Thread: Main.
+bool HunspellService::readLog() {
+	auto f = QFile(CustomDictionaryLogPath());
+	if (f.size() > kMaxDictionaryLogSize || !f.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+	auto log = ::Spellchecker::DictionaryLog::FromSerialized(f.readAll());
+	f.close();
+	if (!log) {
+		// The caller writes a new log instead of the malformed one.
+		return false;
+	}
+	_log = std::move(*log);
+	if (_log.redundantRecords() > kMaxSyncableDictionaryWords) {
+		writeLog();
+	}
+	return true;
+}
+
+// Thread: Main.
+void HunspellService::writeLog() {
+	auto f = QFile(CustomDictionaryLogPath());
+	if (f.open(QIODevice::WriteOnly)) {
+		f.write(_log.delta(0));
+	}
+}
+
+// Thread: Main.
+// Records are appended, the log is rewritten only when it is compacted
+// or when it would grow too large to be read back.
+void HunspellService::appendToLog(uint64 sinceSequence) {
+	auto f = QFile(CustomDictionaryLogPath());
+	if (!f.open(QIODevice::Append)) {
+		return;
+	}
+	const auto records = _log.records(sinceSequence);
+	if (f.size() + records.size() > kMaxDictionaryLogSize) {
+		f.close();
+		writeLog();
+		return;
+	} else if (!f.size()) {
+		f.write(_log.header());
+	}
+	f.write(records);
 }
 
 // Thread: Main.
@@ -398,9 +1195,7 @@ void HunspellService::writeToFile() {
 }
 
 // Thread: Main.
-void HunspellService::readFile() {
-	using namespace ::Spellchecker;
-
+QStringList HunspellService::readWordsFile() {
 	auto f = QFile(CustomDictionaryPath());
 
 	if (const auto info = QFileInfo(f);
@@ -410,17 +1205,30 @@ void HunspellService::readFile() {
 		if (info.isDir()) {
 			QDir(info.path()).removeRecursively();
 		}
-		return;
+		return QStringList();
 	}
 	const auto data = f.readAll();
 	f.close();
-	if (data.isEmpty()) {
+	return data.isEmpty()
+		? QStringList()
+		: QString::fromUtf8(data).split(kLineBreak);
+}
+
+// Thread: Main.
+void HunspellService::readFile() {
+	using namespace ::Spellchecker;
+
+	if (WorkingDirPath().isEmpty()) {
 		return;
 	}
 
+	// The plain list of words is read only before the log is created.
+	const auto logged = readLog();
+
 	// {"a", "1", "β"};
-	auto splitedWords = QString::fromUtf8(data).split(kLineBreak)
-		| ranges::to_vector
+	auto splitedWords = (logged
+		? _log.words()
+		: (readWordsFile() | ranges::to_vector))
 		| ranges::actions::sort
 		| ranges::actions::unique;
 
@@ -435,6 +1243,18 @@ void HunspellService::readFile() {
 		return std::move(word);
 	}) | ranges::to_vector;
 
+	if (!logged) {
+		// Replaces a malformed log even if there are no words,
+		// so the next records are not appended to it.
+		for (const auto &word : filteredWords) {
+			_log.add(word);
+		}
+		writeLog();
+	}
+	if (filteredWords.empty()) {
+		return;
+	}
+
 	ranges::for_each(filteredWords, [&](auto &word) {
 		_customDict->add(word.toStdString());
 	});
@@ -474,14 +1294,34 @@ HunspellService &SharedSpellChecker() {
 
 } // namespace
 
+void Init() {
+	::Spellchecker::PrefetchUsedDictionaries();
+}
+
 bool CheckSpelling(const QString &wordToCheck) {
-	return SharedSpellChecker().checkSpelling(wordToCheck);
+	using namespace ::Spellchecker;
+	auto recorder = WorkloadRecorder(WorkloadCall::CheckWord, wordToCheck);
+	const auto result = SharedSpellChecker().checkSpelling(wordToCheck);
+	recorder.finish(!result);
+	return result;
 }
 
 void FillSuggestionList(
 	const QString &wrongWord,
 	std::vector<QString> *optionalSuggestions) {
+	using namespace ::Spellchecker;
+	auto recorder = WorkloadRecorder(WorkloadCall::Suggest, wrongWord);
 	SharedSpellChecker().fillSuggestionList(wrongWord, optionalSuggestions);
+	recorder.finish(true);
+}
+
+void FillCompletionList(
+	const QString &prefix,
+	std::vector<QString> *completions) {
+	using namespace ::Spellchecker;
+	auto recorder = WorkloadRecorder(WorkloadCall::Complete, prefix);
+	SharedSpellChecker().fillCompletionList(prefix, completions);
+	recorder.finish(completions->empty());
 }
 
 void AddWord(const QString &word) {
@@ -500,6 +1340,16 @@ bool IsWordInDictionary(const QString &wordToCheck) {
 	return SharedSpellChecker().isWordInDictionary(wordToCheck);
 }
 
+QByteArray CustomDictionaryDelta(uint64 sinceSequence) {
+	return SharedSpellChecker().dictionaryDelta(sinceSequence);
+}
+
+bool ApplyCustomDictionaryDelta(
+		const QByteArray &delta,
+		uint64 *peerSequence) {
+	return SharedSpellChecker().applyDictionaryDelta(delta, peerSequence);
+}
+
 void UpdateLanguages(std::vector<int> languages) {
 
 	const auto languageCodes = ranges::view::all(
@@ -512,19 +1362,35 @@ void UpdateLanguages(std::vector<int> languages) {
 	SharedSpellChecker().updateLanguages(languageCodes);
 }
 
+void LoadLanguages(std::vector<QString> languageCodes) {
+	SharedSpellChecker().loadLanguages(std::move(languageCodes));
+}
+
 std::vector<QString> ActiveLanguages() {
 	return SharedSpellChecker().activeLanguages();
 }
 
+EngineCallsStats GetEngineCallsStats() {
+	auto result = EngineCallsStats();
+	result.words = EngineCheckedWords.load();
+	result.calls = EngineCalls.load();
+	return result;
+}
+
+std::vector<SlowCall> WorstSlowCalls() {
+	std::lock_guard lock(SlowCallsMutex);
+	return SlowCallsLog;
+}
+
 void CheckSpellingText(
-	const QString &text,
+	QStringView text,
 	MisspelledWords *misspelledWords) {
-	*misspelledWords = ::Spellchecker::RangesFromText(
-		text,
-		[](const QString &word) {
-			return !::Spellchecker::IsWordSkippable(&word)
-				&& CheckSpelling(word);
-		});
+	using namespace ::Spellchecker;
+	const auto span = TraceSpan("CheckSpellingText");
+	auto recorder = WorkloadRecorder(WorkloadCall::CheckText, text);
+	RangesFromText(text, CheckSkipAndSpell, misspelledWords);
+	recorder.finish(*misspelledWords);
+	VerifyCheckResult(text, *misspelledWords);
 }
 
 } // namespace Platform::Spellchecker::ThirdParty
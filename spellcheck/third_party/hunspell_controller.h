@@ -10,6 +10,11 @@
 
 namespace Platform::Spellchecker::ThirdParty {
 
+// Thread: Main.
+// Starts reading the files of the last used dictionaries into the page
+// cache, so it should be called before the languages are set.
+void Init();
+
 [[nodiscard]] bool CheckSpelling(const QString &wordToCheck);
 [[nodiscard]] bool IsWordInDictionary(const QString &wordToCheck);
 
@@ -17,15 +22,54 @@ std::vector<QString> ActiveLanguages();
 void FillSuggestionList(
 	const QString &wrongWord,
 	std::vector<QString> *optionalSuggestions);
+void FillCompletionList(
+	const QString &prefix,
+	std::vector<QString> *completions);
 
 void AddWord(const QString &word);
 void RemoveWord(const QString &word);
 void IgnoreWord(const QString &word);
 
+// Thread: Main.
+// Added and removed words after the sequence, to send to a sync peer.
+// The last sequence of this device is read from records by the peer.
+[[nodiscard]] QByteArray CustomDictionaryDelta(uint64 sinceSequence);
+
+// Thread: Main.
+// Merges changes from a sync peer, a later change of a word wins.
+// The last seen sequence of the peer is raised to ask it only
+// for newer changes the next time. Returns false for malformed data.
+bool ApplyCustomDictionaryDelta(
+	const QByteArray &delta,
+	uint64 *peerSequence);
+
 void CheckSpellingText(
-	const QString &text,
+	QStringView text,
 	MisspelledWords *misspelledWords);
 
 void UpdateLanguages(std::vector<int> languages);
 
+// Blocking version of UpdateLanguages for tools without the main loop.
+void LoadLanguages(std::vector<QString> languageCodes);
+
+struct EngineCallsStats {
+	int64 words = 0;
+	int64 calls = 0;
+};
+
+// Words that were not found in the custom dictionary
+// and the number of engine spell calls for them.
+[[nodiscard]] EngineCallsStats GetEngineCallsStats();
+
+struct SlowCall {
+	QString lang;
+	uint64 wordHash = 0;
+	crl::time duration = 0;
+	bool suggest = false;
+};
+
+// The slowest calls of Hunspell since the start, the slowest go first.
+// Words are not kept, only their hashes.
+[[nodiscard]] std::vector<SlowCall> WorstSlowCalls();
+
 } // namespace Platform::Spellchecker::ThirdParty
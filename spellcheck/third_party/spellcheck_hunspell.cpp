@@ -10,6 +10,7 @@
 namespace Platform::Spellchecker {
 
 void Init() {
+	ThirdParty::Init();
 }
 
 std::vector<QString> ActiveLanguages() {
@@ -26,16 +27,25 @@ void FillSuggestionList(
 	ThirdParty::FillSuggestionList(wrongWord, variants);
 }
 
+void FillCompletionList(
+		const QString &prefix,
+		std::vector<QString> *completions) {
+	ThirdParty::FillCompletionList(prefix, completions);
+}
+
 void AddWord(const QString &word) {
 	ThirdParty::AddWord(word);
+	::Spellchecker::ClearVerdictCache();
 }
 
 void RemoveWord(const QString &word) {
 	ThirdParty::RemoveWord(word);
+	::Spellchecker::ClearVerdictCache();
 }
 
 void IgnoreWord(const QString &word) {
 	ThirdParty::IgnoreWord(word);
+	::Spellchecker::ClearVerdictCache();
 }
 
 bool IsWordInDictionary(const QString &wordToCheck) {
@@ -43,7 +53,7 @@ bool IsWordInDictionary(const QString &wordToCheck) {
 }
 
 void CheckSpellingText(
-		const QString &text,
+		QStringView text,
 		MisspelledWords *misspelledWords) {
 	ThirdParty::CheckSpellingText(text, misspelledWords);
 }
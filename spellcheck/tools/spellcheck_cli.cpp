@@ -0,0 +1,621 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include "spellcheck/platform/platform_spellcheck.h"
+#include "spellcheck/spellcheck_batch.h"
+#include "spellcheck/spellcheck_kernels.h"
+#include "spellcheck/spellcheck_stream.h"
+#include "spellcheck/spellcheck_trace.h"
+#include "spellcheck/spellcheck_utils.h"
+#include "spellcheck/spellcheck_value.h"
+#include "spellcheck/spellcheck_workload.h"
+#include "spellcheck/third_party/hunspell_controller.h"
+
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QTextStream>
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+
+namespace {
+
+using namespace Platform::Spellchecker;
+
+constexpr auto kMaxReplayLetters = 64;
+constexpr auto kMaxReplayCode = 0x3000;
+// Earlier recordings had word checks nested in text checks.
+constexpr auto kReplayVersion = 2;
+
+struct Source {
+	QString name;
+	std::unique_ptr<QFile> file;
+};
+
+std::vector<QString> AvailableLanguages(const QString &dictionaries) {
+	const auto dir = QDir(dictionaries);
+	return ranges::view::all(
+		dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)
+	) | ranges::views::filter([&](const QString &lang) {
+		return QFile::exists(dir.filePath(lang + '/' + lang + ".dic"));
+	}) | ranges::to_vector;
+}
+
+std::vector<Source> OpenSources(const QStringList &paths) {
+	auto result = std::vector<Source>();
+	if (paths.isEmpty()) {
+		auto input = std::make_unique<QFile>();
+		if (input->open(stdin, QIODevice::ReadOnly)) {
+			result.push_back({ QString("-"), std::move(input) });
+		}
+		return result;
+	}
+	for (const auto &path : paths) {
+		auto file = std::make_unique<QFile>(path);
+		if (!file->open(QIODevice::ReadOnly)) {
+			QTextStream(stderr) << "Can't open " << path << '\n';
+			continue;
+		}
+		result.push_back({ path, std::move(file) });
+	}
+	return result;
+}
+
+void Print(
+		const QString &source,
+		int64 offset,
+		QStringView text,
+		const MisspelledWords &ranges) {
+	if (ranges.empty()) {
+		return;
+	}
+	auto misspelled = QJsonArray();
+	for (const auto &[position, length] : ranges) {
+		misspelled.append(QJsonObject{
+			{ "offset", offset + position },
+			{ "length", length },
+			{ "word", QString(text.data() + position, length) },
+		});
+	}
+	const auto line = QJsonDocument(QJsonObject{
+		{ "source", source },
+		{ "misspelled", misspelled },
+	}).toJson(QJsonDocument::Compact);
+	fwrite(line.constData(), 1, line.size(), stdout);
+	fputc('\n', stdout);
+}
+
+void PrintUnchecked(const QString &source, int64 offset, int length) {
+	const auto line = QJsonDocument(QJsonObject{
+		{ "source", source },
+		{ "unchecked", QJsonObject{
+			{ "offset", offset },
+			{ "length", length },
+		} },
+	}).toJson(QJsonDocument::Compact);
+	fwrite(line.constData(), 1, line.size(), stdout);
+	fputc('\n', stdout);
+}
+
+// Prints results as soon as they are ready, in constant memory.
+// The time of the first checked piece is written to the pointer.
+int64 CheckStreaming(
+		const std::vector<Source> &sources,
+		crl::time *firstChecked) {
+	auto words = int64(0);
+	for (const auto &source : sources) {
+		::Spellchecker::CheckSpellingStream(source.file.get(), [&](
+				int64 offset,
+				QStringView text,
+				const MisspelledWords &ranges,
+				bool checked) {
+			if (!*firstChecked) {
+				*firstChecked = crl::now();
+			}
+			if (!checked) {
+				PrintUnchecked(source.name, offset, text.size());
+				return;
+			}
+			Print(source.name, offset, text, ranges);
+			words += ::Spellchecker::CountWords(text);
+		});
+	}
+	return words;
+}
+
+// Each file is a document, all documents are checked in parallel.
+int64 CheckParallel(const std::vector<Source> &sources, int threads) {
+	const auto texts = ranges::view::all(
+		sources
+	) | ranges::views::transform([](const Source &source) {
+		return QString::fromUtf8(source.file->readAll());
+	}) | ranges::to_vector;
+
+	const auto result = ::Spellchecker::CheckSpellingTexts(texts, threads);
+	for (auto i = 0; i < texts.size(); i++) {
+		Print(sources[i].name, 0, texts[i], result.misspelledWords[i]);
+	}
+	return result.wordsCount;
+}
+
+// Each word of the files is checked alone, twice, so the second pass
+// shows the latency with the caches of the engines filled.
+// Percentiles of the calls are printed in microseconds.
+void PrintWordLatency(const std::vector<Source> &sources) {
+	auto words = std::vector<QString>();
+	for (const auto &source : sources) {
+		const auto text = QString::fromUtf8(source.file->readAll());
+		[[maybe_unused]] const auto none = ::Spellchecker::RangesFromText(
+			text,
+			[&](const QString &word) {
+				words.push_back(word);
+				return true;
+			});
+	}
+	if (words.empty()) {
+		return;
+	}
+	using Clock = std::chrono::steady_clock;
+	for (auto pass = 1; pass != 3; pass++) {
+		auto durations = std::vector<int64>();
+		durations.reserve(words.size());
+		for (const auto &word : words) {
+			const auto start = Clock::now();
+			[[maybe_unused]] const auto result = ThirdParty::CheckSpelling(
+				word);
+			durations.push_back(
+				std::chrono::duration_cast<std::chrono::microseconds>(
+					Clock::now() - start).count());
+		}
+		ranges::sort(durations);
+		const auto percentile = [&](int value) {
+			return durations[(durations.size() - 1) * value / 100];
+		};
+		QTextStream(stderr)
+			<< "Pass " << pass << ": " << words.size() << " words, "
+			<< "p50 " << percentile(50) << " us, "
+			<< "p90 " << percentile(90) << " us, "
+			<< "p99 " << percentile(99) << " us, "
+			<< "max " << durations.back() << " us.\n";
+	}
+}
+
+// Recorded words are replaced by dictionary words of the same script
+// and length, misspelled ones get two letters swapped.
+// The same recorded word is always replaced by the same word.
+class ReplayWords final {
+public:
+	[[nodiscard]] QString word(
+		int id,
+		int length,
+		QChar::Script script,
+		bool misspelled);
+
+private:
+	struct Pool {
+		std::vector<QChar> letters;
+		std::map<int, std::vector<QString>> words;
+	};
+
+	[[nodiscard]] const Pool &pool(QChar::Script script);
+	[[nodiscard]] QString pick(const Pool &pool, int length);
+
+	std::map<QChar::Script, Pool> _pools;
+	std::map<int, QString> _words;
+	std::mt19937 _random;
+
+};
+
+auto ReplayWords::pool(QChar::Script script) -> const Pool & {
+	if (const auto i = _pools.find(script); i != end(_pools)) {
+		return i->second;
+	}
+	auto &result = _pools[script];
+	for (auto code = 0x41; code != kMaxReplayCode; code++) {
+		const auto c = QChar(code);
+		if (c.isLetter() && !c.isUpper() && c.script() == script) {
+			result.letters.push_back(c);
+			if (result.letters.size() == kMaxReplayLetters) {
+				break;
+			}
+		}
+	}
+	auto completions = std::vector<QString>();
+	for (const auto first : result.letters) {
+		for (const auto second : result.letters) {
+			ThirdParty::FillCompletionList(
+				QString(first) + second,
+				&completions);
+			for (auto &completion : completions) {
+				result.words[completion.size()].push_back(
+					std::move(completion));
+			}
+		}
+	}
+	return result;
+}
+
+QString ReplayWords::pick(const Pool &pool, int length) {
+	if (pool.words.empty()) {
+		return pool.letters.empty()
+			? QString(length, QChar('x'))
+			: QString(length, pool.letters.front());
+	}
+	auto i = pool.words.lower_bound(length);
+	if (i == end(pool.words)) {
+		--i;
+	}
+	const auto &words = i->second;
+	return words[_random() % words.size()];
+}
+
+QString ReplayWords::word(
+		int id,
+		int length,
+		QChar::Script script,
+		bool misspelled) {
+	if (const auto i = _words.find(id); i != end(_words)) {
+		return i->second;
+	}
+	auto result = pick(pool(script), length);
+	if (misspelled && result.size() > 2) {
+		const auto position = 1 + int(_random() % (result.size() - 2));
+		const auto c = result.at(position);
+		result[position] = result.at(position + 1);
+		result[position + 1] = c;
+	}
+	return _words.emplace(id, result).first->second;
+}
+
+struct ReplayStats {
+	int calls = 0;
+	int64 recordedMicroseconds = 0;
+	crl::time replayed = 0;
+};
+
+// Calls go one after another as fast as possible,
+// the pauses between the recorded calls are not kept.
+std::map<QString, ReplayStats> Replay(const QJsonArray &events) {
+	auto result = std::map<QString, ReplayStats>();
+	auto words = ReplayWords();
+	auto misspelled = MisspelledWords();
+	auto list = std::vector<QString>();
+	for (const auto &value : events) {
+		const auto event = value.toObject();
+		auto text = QString();
+		for (const auto &entry : event.value("words").toArray()) {
+			const auto word = entry.toArray();
+			if (!text.isEmpty()) {
+				text.append(' ');
+			}
+			text.append(words.word(
+				word.at(0).toInt(),
+				word.at(1).toInt(),
+				QChar::Script(word.at(2).toInt()),
+				word.at(3).toInt() != 0));
+		}
+		const auto call = event.value("call").toString();
+		const auto start = crl::now();
+		if (call == "text") {
+			ThirdParty::CheckSpellingText(text, &misspelled);
+		} else if (call == "word") {
+			[[maybe_unused]] const auto result = ThirdParty::CheckSpelling(
+				text);
+		} else if (call == "suggest") {
+			ThirdParty::FillSuggestionList(text, &list);
+		} else if (call == "complete") {
+			ThirdParty::FillCompletionList(text, &list);
+		} else {
+			continue;
+		}
+		auto &stats = result[call];
+		stats.calls++;
+		stats.recordedMicroseconds += int64(
+			event.value("duration").toDouble());
+		stats.replayed += crl::now() - start;
+	}
+	return result;
+}
+
+// The custom dictionary of the working dir is one device,
+// delta files stand in for the sync peer.
+int Sync(
+		const QStringList &add,
+		const QStringList &remove,
+		const QString &applyPath,
+		const QString &exportPath,
+		uint64 since) {
+	for (const auto &word : add) {
+		ThirdParty::AddWord(word);
+	}
+	for (const auto &word : remove) {
+		ThirdParty::RemoveWord(word);
+	}
+	if (!applyPath.isEmpty()) {
+		auto file = QFile(applyPath);
+		if (!file.open(QIODevice::ReadOnly)) {
+			QTextStream(stderr) << "Can't open " << applyPath << '\n';
+			return 1;
+		}
+		auto peerSequence = uint64(0);
+		if (!ThirdParty::ApplyCustomDictionaryDelta(
+				file.readAll(),
+				&peerSequence)) {
+			QTextStream(stderr) << "Bad delta in " << applyPath << '\n';
+			return 1;
+		}
+		QTextStream(stderr) << "Peer sequence: " << peerSequence << ".\n";
+	}
+	if (!exportPath.isEmpty()) {
+		auto file = QFile(exportPath);
+		if (!file.open(QIODevice::WriteOnly)) {
+			QTextStream(stderr) << "Can't write " << exportPath << '\n';
+			return 1;
+		}
+		const auto delta = ThirdParty::CustomDictionaryDelta(since);
+		file.write(delta);
+		QTextStream(stderr) << "Delta: " << delta.size() << " bytes.\n";
+	}
+	return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+	auto app = QCoreApplication(argc, argv);
+
+	auto parser = QCommandLineParser();
+	parser.setApplicationDescription("Checks spelling of text files "
+		"or stdin and prints misspelled words as JSON lines.");
+	parser.addHelpOption();
+	const auto dictionariesOption = QCommandLineOption(
+		{ "d", "dictionaries" },
+		"Directory with <lang>/<lang>.aff and <lang>/<lang>.dic files.",
+		"path");
+	const auto languagesOption = QCommandLineOption(
+		{ "l", "languages" },
+		"Comma separated languages, all found ones by default.",
+		"list");
+	const auto parallelOption = QCommandLineOption(
+		{ "p", "parallel" },
+		"Check whole files in parallel instead of streaming lines.");
+	const auto threadsOption = QCommandLineOption(
+		{ "t", "threads" },
+		"Number of threads for the parallel mode.",
+		"count",
+		"0");
+	const auto statsOption = QCommandLineOption(
+		{ "s", "stats" },
+		"Print timing and cache statistics to stderr.");
+	const auto preferOption = QCommandLineOption(
+		"prefer",
+		"Comma separated languages to probe first.",
+		"list");
+	const auto traceOption = QCommandLineOption(
+		"trace",
+		"Write spans of the checking to a Chrome trace JSON file.",
+		"file");
+	const auto addWordsOption = QCommandLineOption(
+		"add-words",
+		"Comma separated words to add to the custom dictionary.",
+		"list");
+	const auto removeWordsOption = QCommandLineOption(
+		"remove-words",
+		"Comma separated words to remove from the custom dictionary.",
+		"list");
+	const auto applyDeltaOption = QCommandLineOption(
+		"apply-delta",
+		"Merge custom dictionary changes of a sync peer from a file.",
+		"file");
+	const auto exportDeltaOption = QCommandLineOption(
+		"export-delta",
+		"Write custom dictionary changes after --since to a file.",
+		"file");
+	const auto sinceOption = QCommandLineOption(
+		"since",
+		"The last sequence of this device seen by the sync peer.",
+		"sequence",
+		"0");
+	const auto verifyOption = QCommandLineOption(
+		"verify",
+		"Check one of every N texts again without caches and shortcuts.",
+		"N");
+	const auto kernelsOption = QCommandLineOption(
+		"kernels",
+		"Text routines variant: scalar, sse42, avx2 or neon.",
+		"name");
+	const auto recordOption = QCommandLineOption(
+		"record",
+		"Write the shape of the checking load without text to a file.",
+		"file");
+	const auto replayOption = QCommandLineOption(
+		"replay",
+		"Check synthetic words in the shape of a recorded load.",
+		"file");
+	const auto latencyOption = QCommandLineOption(
+		"latency",
+		"Print percentiles of the check time of each word of the files.");
+	parser.addOptions({
+		dictionariesOption,
+		languagesOption,
+		parallelOption,
+		threadsOption,
+		statsOption,
+		preferOption,
+		traceOption,
+		addWordsOption,
+		removeWordsOption,
+		applyDeltaOption,
+		exportDeltaOption,
+		sinceOption,
+		recordOption,
+		replayOption,
+		latencyOption,
+		kernelsOption,
+		verifyOption,
+	});
+	parser.addPositionalArgument("files", "Files to check.", "[files...]");
+	parser.process(app);
+
+	const auto dictionaries = parser.value(dictionariesOption);
+	if (dictionaries.isEmpty()) {
+		parser.showHelp(1);
+	}
+	::Spellchecker::SetWorkingDirPath(dictionaries);
+	::Spellchecker::SetTraceEnabled(parser.isSet(traceOption));
+	if (parser.isSet(kernelsOption)) {
+		const auto kernels = ::Spellchecker::TextKernelsFromName(
+			parser.value(kernelsOption));
+		if (!kernels || !::Spellchecker::SetTextKernels(*kernels)) {
+			QTextStream(stderr)
+				<< "Unsupported kernels " << parser.value(kernelsOption)
+				<< ".\n";
+			return 1;
+		}
+	}
+
+	if (parser.isSet(addWordsOption)
+		|| parser.isSet(removeWordsOption)
+		|| parser.isSet(applyDeltaOption)
+		|| parser.isSet(exportDeltaOption)) {
+		const auto list = [&](const QCommandLineOption &option) {
+			return parser.isSet(option)
+				? parser.value(option).split(',')
+				: QStringList();
+		};
+		return Sync(
+			list(addWordsOption),
+			list(removeWordsOption),
+			parser.value(applyDeltaOption),
+			parser.value(exportDeltaOption),
+			parser.value(sinceOption).toULongLong());
+	}
+
+	const auto languages = parser.isSet(languagesOption)
+		? (parser.value(languagesOption).split(',') | ranges::to_vector)
+		: AvailableLanguages(dictionaries);
+
+	const auto started = crl::now();
+	auto timer = started;
+	ThirdParty::LoadLanguages(languages);
+	const auto loadTime = crl::now() - timer;
+	if (ActiveLanguages().empty()) {
+		QTextStream(stderr) << "No dictionaries loaded.\n";
+		return 1;
+	}
+
+	if (parser.isSet(replayOption)) {
+		auto file = QFile(parser.value(replayOption));
+		if (!file.open(QIODevice::ReadOnly)) {
+			QTextStream(stderr) << "Can't open " << file.fileName() << '\n';
+			return 1;
+		}
+		const auto recording = QJsonDocument::fromJson(
+			file.readAll()
+		).object();
+		if (recording.value("version").toInt() != kReplayVersion) {
+			QTextStream(stderr)
+				<< "Unsupported recording " << file.fileName() << '\n';
+			return 1;
+		}
+		const auto events = recording.value("events").toArray();
+		for (const auto &[call, stats] : Replay(events)) {
+			QTextStream(stderr)
+				<< call << ": " << stats.calls << " calls, "
+				<< (stats.recordedMicroseconds / 1000) << " ms recorded, "
+				<< stats.replayed << " ms replayed.\n";
+		}
+		return 0;
+	}
+
+	const auto sources = OpenSources(parser.positionalArguments());
+	if (parser.isSet(latencyOption)) {
+		PrintWordLatency(sources);
+		return 0;
+	}
+
+	::Spellchecker::SetWorkloadRecording(parser.isSet(recordOption));
+	::Spellchecker::SetShadowVerification(
+		parser.value(verifyOption).toInt());
+	const auto hint = ::Spellchecker::LanguageHint(parser.isSet(preferOption)
+		? (parser.value(preferOption).split(',') | ranges::to_vector)
+		: std::vector<QString>());
+	timer = crl::now();
+	auto firstChecked = crl::time(0);
+	const auto words = parser.isSet(parallelOption)
+		? CheckParallel(sources, parser.value(threadsOption).toInt())
+		: CheckStreaming(sources, &firstChecked);
+	const auto checkTime = crl::now() - timer;
+	fflush(stdout);
+
+	if (parser.isSet(recordOption)) {
+		::Spellchecker::SetWorkloadRecording(false);
+		auto record = QFile(parser.value(recordOption));
+		if (record.open(QIODevice::WriteOnly)) {
+			record.write(::Spellchecker::WorkloadToJson());
+		} else {
+			QTextStream(stderr) << "Can't write " << record.fileName() << '\n';
+		}
+	}
+
+	if (parser.isSet(traceOption)) {
+		auto trace = QFile(parser.value(traceOption));
+		if (trace.open(QIODevice::WriteOnly)) {
+			trace.write(::Spellchecker::TraceToJson());
+		} else {
+			QTextStream(stderr) << "Can't write " << trace.fileName() << '\n';
+		}
+	}
+
+	if (parser.isSet(statsOption)) {
+		const auto cache = ::Spellchecker::GetVerdictCacheStats();
+		QTextStream(stderr)
+			<< "Languages: " << ActiveLanguages().size()
+			<< ", loaded in " << loadTime << " ms.\n";
+		if (firstChecked) {
+			// With a cold page cache this is the first check latency.
+			QTextStream(stderr)
+				<< "First piece checked " << (firstChecked - started)
+				<< " ms after the start.\n";
+		}
+		QTextStream(stderr)
+			<< "Words: " << words
+			<< ", checked in " << checkTime << " ms, "
+			<< (checkTime ? (words * 1000 / checkTime) : 0)
+			<< " words/s.\n"
+			<< "Text kernels: " << ::Spellchecker::TextKernelsName(
+				::Spellchecker::ActiveTextKernels()) << ".\n"
+			<< "Verdict cache: " << cache.hits << " hits, "
+			<< cache.misses << " misses, "
+			<< cache.size << " words.\n";
+		if (parser.isSet(verifyOption)) {
+			const auto shadow = ::Spellchecker::GetShadowVerificationStats();
+			QTextStream(stderr)
+				<< "Verified texts: " << shadow.verified << ", "
+				<< shadow.mismatches << " mismatched, "
+				<< shadow.mismatchedWords << " words differ.\n";
+		}
+		const auto calls = ThirdParty::GetEngineCallsStats();
+		QTextStream(stderr)
+			<< "Engine calls: " << calls.calls << " for "
+			<< calls.words << " words.\n";
+		for (const auto &call : ThirdParty::WorstSlowCalls()) {
+			QTextStream(stderr)
+				<< "Slow " << (call.suggest ? "suggest" : "spell")
+				<< ": " << call.lang
+				<< ", word hash " << QString::number(call.wordHash, 16)
+				<< ", " << call.duration << " ms.\n";
+		}
+	}
+	return 0;
+}
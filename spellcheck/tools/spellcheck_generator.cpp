@@ -0,0 +1,453 @@
+// This file is part of Desktop App Toolkit,
+// a set of libraries for developing nice desktop applications.
+//
+// For license and copyright information please follow this link:
+// https://github.com/desktop-app/legal/blob/master/LEGAL
+//
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QSet>
+#include <QtCore/QTextCodec>
+#include <QtCore/QTextStream>
+
+#include <array>
+#include <random>
+
+namespace {
+
+constexpr auto kMinSyllables = 1;
+constexpr auto kMaxSyllables = 5;
+constexpr auto kMaxFlagsPerWord = 2;
+constexpr auto kWordsPerLine = 12;
+constexpr auto kMaxMisspellingAttempts = 8;
+
+struct Alphabet {
+	QString name;
+	QString lang;
+	QString consonants;
+	QString vowels;
+};
+
+const auto kAlphabets = std::vector<Alphabet>{
+	{
+		"latin",
+		"en_US",
+		"bcdfghjklmnpqrstvwxz",
+		"aeiouy",
+	},
+	{
+		"cyrillic",
+		"ru_RU",
+		QString::fromUtf8("бвгджзклмнпрстфхцчшщ"),
+		QString::fromUtf8("аеиоуыэюя"),
+	},
+	{
+		"greek",
+		"el_GR",
+		QString::fromUtf8("βγδζθκλμνξπρστφχψ"),
+		QString::fromUtf8("αεηιουω"),
+	},
+};
+
+struct Affix {
+	bool prefix = false;
+	QString text;
+};
+
+struct Entry {
+	QString word;
+	std::array<int, kMaxFlagsPerWord> flags = { -1, -1 };
+};
+
+// The distributions of the standard library are implementation-defined,
+// so the same seed would give different output on different platforms.
+class Random final {
+public:
+	explicit Random(uint64 seed) : _engine(seed) {
+	}
+
+	[[nodiscard]] int below(int count) {
+		return int(_engine() % uint64(count));
+	}
+	[[nodiscard]] double unit() {
+		return (_engine() >> 11) * (1. / (uint64(1) << 53));
+	}
+	[[nodiscard]] QChar pick(const QString &letters) {
+		return letters.at(below(letters.size()));
+	}
+
+private:
+	std::mt19937_64 _engine;
+
+};
+
+const Alphabet *FindAlphabet(const QString &name) {
+	const auto it = ranges::find(kAlphabets, name, &Alphabet::name);
+	return (it != end(kAlphabets)) ? &*it : nullptr;
+}
+
+QString GenerateWord(Random &random, const Alphabet &alphabet) {
+	auto result = QString();
+	const auto syllables = kMinSyllables
+		+ random.below(kMaxSyllables - kMinSyllables + 1);
+	for (auto i = 0; i < syllables; i++) {
+		result.append(random.pick(alphabet.consonants));
+		result.append(random.pick(alphabet.vowels));
+		if (random.below(4) == 0) {
+			result.append(random.pick(alphabet.consonants));
+		}
+	}
+	return result;
+}
+
+std::vector<Affix> GenerateAffixes(
+		Random &random,
+		const Alphabet &alphabet,
+		int count) {
+	auto result = std::vector<Affix>();
+	result.reserve(count);
+	for (auto i = 0; i < count; i++) {
+		auto affix = Affix();
+		// Suffixes are much more common in real dictionaries.
+		affix.prefix = (random.below(4) == 0);
+		const auto length = 1 + random.below(3);
+		for (auto j = 0; j < length; j++) {
+			affix.text.append(random.pick((j % 2)
+				? alphabet.consonants
+				: alphabet.vowels));
+		}
+		result.push_back(std::move(affix));
+	}
+	return result;
+}
+
+std::vector<Entry> GenerateEntries(
+		Random &random,
+		const Alphabet &alphabet,
+		int count,
+		int affixesCount) {
+	auto unique = QSet<QString>();
+	unique.reserve(count);
+	auto result = std::vector<Entry>();
+	result.reserve(count);
+	// Short words run out quickly, so the attempts are limited.
+	for (auto attempts = 0; result.size() < count
+		&& attempts < count * 4; attempts++) {
+		auto entry = Entry{ GenerateWord(random, alphabet) };
+		if (unique.contains(entry.word)) {
+			continue;
+		}
+		unique.insert(entry.word);
+		if (affixesCount > 0) {
+			for (auto &flag : entry.flags) {
+				if (random.below(2)) {
+					flag = random.below(affixesCount);
+				}
+			}
+		}
+		result.push_back(std::move(entry));
+	}
+	return result;
+}
+
+QString Apply(const Affix &affix, const QString &word) {
+	return affix.prefix ? (affix.text + word) : (word + affix.text);
+}
+
+QString AffixFile(
+		const Alphabet &alphabet,
+		const std::vector<Affix> &affixes,
+		const QString &encoding) {
+	auto result = QString();
+	auto stream = QTextStream(&result);
+	stream << "SET " << encoding << '\n';
+	stream << "FLAG num\n";
+	stream << "TRY " << alphabet.vowels << alphabet.consonants << '\n';
+	for (auto i = 0; i < affixes.size(); i++) {
+		// Numeric flags start from 1.
+		const auto flag = i + 1;
+		const auto type = affixes[i].prefix ? "PFX" : "SFX";
+		stream << '\n';
+		stream << type << ' ' << flag << " Y 1\n";
+		stream << type << ' ' << flag << " 0 " << affixes[i].text << " .\n";
+	}
+	stream.flush();
+	return result;
+}
+
+QString DictionaryLine(const Entry &entry) {
+	auto flags = QStringList();
+	for (const auto flag : entry.flags) {
+		if (flag >= 0) {
+			flags.push_back(QString::number(flag + 1));
+		}
+	}
+	return (flags.isEmpty()
+		? entry.word
+		: (entry.word + '/' + flags.join(','))) + '\n';
+}
+
+QString Misspell(Random &random, const Alphabet &alphabet, QString word) {
+	const auto position = random.below(word.size());
+	switch (random.below(4)) {
+	case 0:
+		word[position] = random.pick(alphabet.vowels);
+		break;
+	case 1:
+		word.insert(position, random.pick(alphabet.consonants));
+		break;
+	case 2:
+		if (word.size() > 2) {
+			word.remove(position, 1);
+		}
+		break;
+	case 3:
+		if (position + 1 < word.size()) {
+			const auto c = word.at(position);
+			word[position] = word.at(position + 1);
+			word[position + 1] = c;
+		}
+		break;
+	}
+	return word;
+}
+
+// "cyrillic:0.1,greek:0.05" means 10% of Cyrillic words
+// and 5% of Greek words that are not in the dictionary's script.
+std::vector<std::pair<const Alphabet*, double>> ParseMix(
+		const QString &value) {
+	auto result = std::vector<std::pair<const Alphabet*, double>>();
+	for (const auto &part : value.split(',')) {
+		if (part.isEmpty()) {
+			continue;
+		}
+		const auto pair = part.split(':');
+		const auto alphabet = FindAlphabet(pair.front());
+		if (!alphabet || pair.size() != 2) {
+			QTextStream(stderr) << "Bad script mix: " << part << '\n';
+			continue;
+		}
+		result.emplace_back(alphabet, pair.back().toDouble());
+	}
+	return result;
+}
+
+bool WriteFile(const QString &path, const QByteArray &data) {
+	auto f = QFile(path);
+	if (!f.open(QIODevice::WriteOnly) || f.write(data) != data.size()) {
+		QTextStream(stderr) << "Can't write " << path << '\n';
+		return false;
+	}
+	return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+	auto app = QCoreApplication(argc, argv);
+
+	auto parser = QCommandLineParser();
+	parser.setApplicationDescription("Generates reproducible Hunspell "
+		"dictionaries and texts for scaling experiments.");
+	parser.addHelpOption();
+	const auto outputOption = QCommandLineOption(
+		{ "o", "output" },
+		"Directory to write <lang>/<lang>.aff and <lang>/<lang>.dic to.",
+		"path");
+	const auto scriptOption = QCommandLineOption(
+		"script",
+		"Alphabet of the dictionary: latin, cyrillic or greek.",
+		"name",
+		"latin");
+	const auto langOption = QCommandLineOption(
+		"lang",
+		"Language code of the dictionary, derived from the script "
+		"by default.",
+		"code");
+	const auto wordsOption = QCommandLineOption(
+		{ "w", "words" },
+		"Number of dictionary words.",
+		"count",
+		"10000");
+	const auto affixesOption = QCommandLineOption(
+		{ "a", "affixes" },
+		"Number of affix rules.",
+		"count",
+		"20");
+	const auto encodingOption = QCommandLineOption(
+		{ "e", "encoding" },
+		"Encoding of the dictionary, for example ISO8859-1 or KOI8-R.",
+		"name",
+		"UTF-8");
+	const auto seedOption = QCommandLineOption(
+		"seed",
+		"Seed of the generator.",
+		"number",
+		"0");
+	const auto corpusOption = QCommandLineOption(
+		{ "c", "corpus" },
+		"File to write a text made of the dictionary words to.",
+		"file");
+	const auto corpusWordsOption = QCommandLineOption(
+		"corpus-words",
+		"Number of words in the text.",
+		"count",
+		"100000");
+	const auto misspellingsOption = QCommandLineOption(
+		{ "m", "misspellings" },
+		"Fraction of misspelled words in the text.",
+		"rate",
+		"0.05");
+	const auto mixOption = QCommandLineOption(
+		"mix",
+		"Fractions of words in other scripts, like cyrillic:0.1.",
+		"list");
+	parser.addOptions({
+		outputOption,
+		scriptOption,
+		langOption,
+		wordsOption,
+		affixesOption,
+		encodingOption,
+		seedOption,
+		corpusOption,
+		corpusWordsOption,
+		misspellingsOption,
+		mixOption,
+	});
+	parser.process(app);
+
+	const auto output = parser.value(outputOption);
+	const auto alphabet = FindAlphabet(parser.value(scriptOption));
+	if (output.isEmpty() || !alphabet) {
+		parser.showHelp(1);
+	}
+	const auto lang = parser.isSet(langOption)
+		? parser.value(langOption)
+		: alphabet->lang;
+	const auto encoding = parser.value(encodingOption);
+	const auto codec = QTextCodec::codecForName(encoding.toLatin1());
+	if (!codec
+		|| !codec->canEncode(alphabet->consonants + alphabet->vowels)) {
+		QTextStream(stderr)
+			<< "Encoding " << encoding << " can't be used for "
+			<< alphabet->name << " words.\n";
+		return 1;
+	}
+
+	auto random = Random(parser.value(seedOption).toULongLong());
+	const auto affixes = GenerateAffixes(
+		random,
+		*alphabet,
+		std::max(parser.value(affixesOption).toInt(), 0));
+	const auto entries = GenerateEntries(
+		random,
+		*alphabet,
+		std::max(parser.value(wordsOption).toInt(), 1),
+		affixes.size());
+
+	const auto dir = QDir(output).filePath(lang);
+	if (!QDir().mkpath(dir)) {
+		QTextStream(stderr) << "Can't create " << dir << '\n';
+		return 1;
+	}
+	const auto base = dir + '/' + lang;
+	auto dictionary = QString::number(qlonglong(entries.size())) + '\n';
+	for (const auto &entry : entries) {
+		dictionary += DictionaryLine(entry);
+	}
+	const auto aff = AffixFile(*alphabet, affixes, encoding);
+	if (!WriteFile(base + ".aff", codec->fromUnicode(aff))
+		|| !WriteFile(base + ".dic", codec->fromUnicode(dictionary))) {
+		return 1;
+	}
+	QTextStream(stderr)
+		<< "Dictionary: " << entries.size() << " words, "
+		<< affixes.size() << " affixes.\n";
+
+	if (!parser.isSet(corpusOption)) {
+		return 0;
+	}
+	auto corpus = QFile(parser.value(corpusOption));
+	if (!corpus.open(QIODevice::WriteOnly)) {
+		QTextStream(stderr) << "Can't write " << corpus.fileName() << '\n';
+		return 1;
+	}
+	const auto mix = ParseMix(parser.value(mixOption));
+	const auto rate = parser.value(misspellingsOption).toDouble();
+	const auto count = std::max(parser.value(corpusWordsOption).toInt(), 0);
+	// Typos should not be any of the accepted forms. All the affixes
+	// allow the cross product, so a prefix and a suffix of the same
+	// word are also accepted together.
+	const auto known = [&] {
+		auto result = QSet<QString>();
+		result.reserve(entries.size() * 4);
+		for (const auto &entry : entries) {
+			result.insert(entry.word);
+			for (const auto flag : entry.flags) {
+				if (flag < 0) {
+					continue;
+				}
+				const auto &affix = affixes[flag];
+				result.insert(Apply(affix, entry.word));
+				if (!affix.prefix) {
+					continue;
+				}
+				for (const auto other : entry.flags) {
+					if (other >= 0 && !affixes[other].prefix) {
+						result.insert(
+							Apply(affix, Apply(affixes[other], entry.word)));
+					}
+				}
+			}
+		}
+		return result;
+	}();
+	auto misspelled = 0;
+	auto line = QString();
+	for (auto i = 0; i < count; i++) {
+		const auto &entry = entries[random.below(entries.size())];
+		auto word = entry.word;
+		if (const auto flag = entry.flags[random.below(kMaxFlagsPerWord)];
+			flag >= 0 && random.below(2)) {
+			word = Apply(affixes[flag], word);
+		}
+
+		auto roll = random.unit();
+		auto other = (const Alphabet*)nullptr;
+		for (const auto &[script, fraction] : mix) {
+			if (roll < fraction) {
+				other = script;
+				break;
+			}
+			roll -= fraction;
+		}
+		if (other) {
+			word = GenerateWord(random, *other);
+		} else if (random.unit() < rate) {
+			for (auto j = 0; j < kMaxMisspellingAttempts; j++) {
+				const auto typo = Misspell(random, *alphabet, word);
+				if (typo != word && !known.contains(typo)) {
+					word = typo;
+					misspelled++;
+					break;
+				}
+			}
+		}
+
+		line += word;
+		if ((i + 1) % kWordsPerLine && (i + 1) < count) {
+			line += ' ';
+		} else {
+			line += '\n';
+			corpus.write(line.toUtf8());
+			line.clear();
+		}
+	}
+	QTextStream(stderr)
+		<< "Corpus: " << count << " words, "
+		<< misspelled << " misspelled.\n";
+	return 0;
+}